@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+
+namespace mcts
+{
+// 3x3 board stored as a 9-bit mask, bit `row * 3 + col` is set for an occupied cell
+namespace bitboard
+{
+using Mask = uint16_t;
+
+const int SIZE = 3;
+const int CELLS = SIZE * SIZE;
+const Mask FULL = ( 1 << CELLS ) - 1;
+
+const Mask LINES[] = {
+    0007, 0070, 0700,  // rows
+    0111, 0222, 0444,  // cols
+    0421, 0124,        // diagonals
+};
+
+// Lines through every cell, padded with the first line of the cell
+const Mask CELL_LINES[ CELLS ][ 4 ] = {
+    {0007, 0111, 0421, 0007},
+    {0007, 0222, 0007, 0007},
+    {0007, 0444, 0124, 0007},
+    {0070, 0111, 0070, 0070},
+    {0070, 0222, 0421, 0124},
+    {0070, 0444, 0070, 0070},
+    {0700, 0111, 0124, 0700},
+    {0700, 0222, 0700, 0700},
+    {0700, 0444, 0421, 0700},
+};
+
+inline int
+cell_index( int row, int col )
+{
+    return row * SIZE + col;
+}
+
+inline Mask
+cell_mask( int index )
+{
+    return static_cast< Mask >( 1 << index );
+}
+
+inline bool
+is_win( Mask mask )
+{
+    for ( auto line : LINES )
+    {
+        if ( ( mask & line ) == line )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Only the lines through the last played cell can be completed by it
+inline bool
+is_win_through( Mask mask, int index )
+{
+    for ( auto line : CELL_LINES[ index ] )
+    {
+        if ( ( mask & line ) == line )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline int
+count( Mask mask )
+{
+#if defined( __GNUC__ )
+    return __builtin_popcount( mask );
+#else
+    int cnt = 0;
+    for ( ; mask; mask &= mask - 1 )
+    {
+        ++cnt;
+    }
+    return cnt;
+#endif
+}
+
+inline int
+lowest( Mask mask )
+{
+#if defined( __GNUC__ )
+    return __builtin_ctz( mask );
+#else
+    int index = 0;
+    while ( !( mask & 1 ) )
+    {
+        mask >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+// Index of the n-th (zero based) set bit
+inline int
+nth( Mask mask, int n )
+{
+    while ( n-- > 0 )
+    {
+        mask &= mask - 1;
+    }
+    return lowest( mask );
+}
+
+}  // namespace bitboard
+}  // namespace mcts
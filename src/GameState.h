@@ -0,0 +1,87 @@
+#pragma once
+
+#include "MctsState.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace mcts
+{
+// Exposes a game of the Mcts< Game > template through the virtual MctsState interface
+template < typename Game >
+struct GameState : public MctsState
+{
+    explicit GameState( typename Game::State state, Move move = -1 )
+        : m_state( std::move( state ) )
+        , m_move( move )
+    {
+    }
+
+    Result
+    simulate( RandomEngine& random ) const override
+    {
+        return Game::simulate( m_state, random );
+    }
+
+    bool
+    is_my_turn( ) const override
+    {
+        return Game::is_my_turn( m_state );
+    }
+
+    States
+    get_children( ) const override
+    {
+        typename Game::Moves moves;
+        Game::get_moves( m_state, moves );
+
+        States children;
+        children.reserve( moves.size( ) );
+        for ( auto const move : moves )
+        {
+            auto state = m_state;
+            Game::play( state, move );
+            children.emplace_back( new GameState( std::move( state ), move ) );
+        }
+        return children;
+    }
+
+    std::unique_ptr< MctsState >
+    play( Move move ) const override
+    {
+        typename Game::Moves moves;
+        Game::get_moves( m_state, moves );
+        if ( std::find( moves.begin( ), moves.end( ), move ) == moves.end( ) )
+        {
+            return nullptr;
+        }
+
+        auto state = m_state;
+        Game::play( state, move );
+        return std::unique_ptr< MctsState >( new GameState( std::move( state ), move ) );
+    }
+
+    Move
+    get_move( ) const override
+    {
+        return m_move;
+    }
+
+    Hash
+    get_hash( ) const override
+    {
+        return Game::get_hash( m_state );
+    }
+
+    const typename Game::State&
+    get_state( ) const
+    {
+        return m_state;
+    }
+
+private:
+    typename Game::State m_state;
+    Move m_move;
+};
+
+}  // namespace mcts
@@ -0,0 +1,109 @@
+#include "MappedFile.h"
+
+#include <fstream>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#define MCTS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mcts
+{
+MappedFile::MappedFile( )
+    : m_data( nullptr )
+    , m_size( 0 )
+    , m_mapping( nullptr )
+{
+}
+
+MappedFile::~MappedFile( )
+{
+    close( );
+}
+
+bool
+MappedFile::open( const std::string& path )
+{
+    close( );
+
+#if defined( MCTS_MMAP )
+    auto const file = ::open( path.c_str( ), O_RDONLY );
+    if ( file < 0 )
+    {
+        return false;
+    }
+
+    struct stat status;
+    if ( fstat( file, &status ) == 0 && status.st_size > 0 )
+    {
+        auto const size = static_cast< size_t >( status.st_size );
+        auto const mapping = mmap( nullptr, size, PROT_READ, MAP_SHARED, file, 0 );
+        if ( mapping != MAP_FAILED )
+        {
+            m_mapping = mapping;
+            m_data = mapping;
+            m_size = size;
+        }
+    }
+    ::close( file );
+#else
+    std::ifstream file( path, std::ios::binary | std::ios::ate );
+    if ( file )
+    {
+        auto const size = static_cast< size_t >( file.tellg( ) );
+        m_contents.resize( ( size + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t ) );
+        file.seekg( 0 );
+        if ( size > 0
+             && file.read( reinterpret_cast< char* >( m_contents.data( ) ),
+                           static_cast< std::streamsize >( size ) ) )
+        {
+            m_data = m_contents.data( );
+            m_size = size;
+        }
+    }
+#endif
+
+    if ( !m_data )
+    {
+        close( );
+    }
+    return is_open( );
+}
+
+bool
+MappedFile::is_open( ) const
+{
+    return m_data != nullptr;
+}
+
+const void*
+MappedFile::data( ) const
+{
+    return m_data;
+}
+
+size_t
+MappedFile::size( ) const
+{
+    return m_size;
+}
+
+void
+MappedFile::close( )
+{
+#if defined( MCTS_MMAP )
+    if ( m_mapping )
+    {
+        munmap( m_mapping, m_size );
+    }
+#endif
+    m_mapping = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    m_contents.clear( );
+}
+
+}  // namespace mcts
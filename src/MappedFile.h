@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mcts
+{
+// Read-only contents of a whole file. The file is mapped into memory where the platform
+// supports it and read with a single streaming read otherwise. The data is aligned for 64-bit
+// words either way.
+struct MappedFile
+{
+    MappedFile( );
+    ~MappedFile( );
+
+    MappedFile( const MappedFile& ) = delete;
+    MappedFile& operator=( const MappedFile& ) = delete;
+
+    // False when the file cannot be read or is empty
+    bool open( const std::string& path );
+    bool is_open( ) const;
+    const void* data( ) const;
+    size_t size( ) const;
+    void close( );
+
+private:
+    const void* m_data;
+    size_t m_size;
+    // Mapped file, or its contents where files cannot be mapped
+    void* m_mapping;
+    std::vector< uint64_t > m_contents;
+};
+
+}  // namespace mcts
@@ -0,0 +1,153 @@
+#include "MatchServer.h"
+#include "TicTacToeBigGame.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Plays many games against random opponents on one match server and reports how long the
+// replies of the AI took
+//
+//     match_driver [games] [threads] [iterations] [time_budget_ms]
+
+namespace
+{
+using namespace mcts;
+using Clock = std::chrono::steady_clock;
+
+struct Results
+{
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t games_left;
+    std::vector< std::chrono::microseconds > latencies;
+};
+
+// One game and its opponent, only touched by the callbacks of that game which run one at a time
+struct Game
+{
+    Game( MatchServer& server, Results& results, GameId id, uint64_t seed )
+        : server( server )
+        , results( results )
+        , id( id )
+        , state( TicTacToeBigGame::make_state(
+              TicTacToeBigGame::Boards{}, TicTacToeBigGame::Boards{}, true ) )
+        , random( seed )
+        , requested( Clock::now( ) )
+    {
+    }
+
+    void
+    on_my_move( MovePosition position )
+    {
+        auto const latency = std::chrono::duration_cast< std::chrono::microseconds >(
+            Clock::now( ) - requested );
+
+        TicTacToeBigGame::Moves moves;
+        if ( position.row >= 0 )
+        {
+            TicTacToeBigGame::play( state, position.row * TicTacToeBigGame::BOARD_SIZE
+                                               + position.col );
+            TicTacToeBigGame::get_moves( state, moves );
+        }
+
+        if ( moves.size( ) > 0 )
+        {
+            auto const move = moves[ bounded( random, moves.size( ) ) ];
+            TicTacToeBigGame::play( state, move );
+            moves.clear( );
+            TicTacToeBigGame::get_moves( state, moves );
+            if ( moves.size( ) > 0 )
+            {
+                record( latency, false );
+                requested = Clock::now( );
+                server.opponent_move( id,
+                                      {move / TicTacToeBigGame::BOARD_SIZE,
+                                       move % TicTacToeBigGame::BOARD_SIZE},
+                                      [this]( MovePosition reply ) { on_my_move( reply ); } );
+                return;
+            }
+        }
+
+        server.end_game( id );
+        record( latency, true );
+    }
+
+    void
+    record( std::chrono::microseconds latency, bool game_over )
+    {
+        std::lock_guard< std::mutex > lock( results.mutex );
+        results.latencies.push_back( latency );
+        if ( game_over && --results.games_left == 0 )
+        {
+            results.finished.notify_one( );
+        }
+    }
+
+    MatchServer& server;
+    Results& results;
+    const GameId id;
+    TicTacToeBigGame::State state;
+    RandomEngine random;
+    Clock::time_point requested;
+};
+
+std::chrono::microseconds
+get_percentile( const std::vector< std::chrono::microseconds >& sorted, double percentile )
+{
+    return sorted[ std::min( sorted.size( ) - 1,
+                             static_cast< size_t >( percentile * sorted.size( ) ) ) ];
+}
+
+}  // namespace
+
+int
+main( int argc, char** argv )
+{
+    auto const games = argc > 1 ? std::strtoul( argv[ 1 ], nullptr, 10 ) : 100;
+    MatchSettings settings;
+    if ( argc > 2 )
+    {
+        settings.threads = std::strtoul( argv[ 2 ], nullptr, 10 );
+    }
+    settings.search.iterations = argc > 3 ? std::strtoul( argv[ 3 ], nullptr, 10 ) : 200;
+    settings.search.time_budget
+        = std::chrono::milliseconds( argc > 4 ? std::strtoul( argv[ 4 ], nullptr, 10 ) : 0 );
+
+    Results results;
+    results.games_left = games;
+    std::vector< std::unique_ptr< Game > > sessions;
+    auto const start = Clock::now( );
+    {
+        MatchServer server( settings );
+        TicTacToeGameAI::AvailableCells const available(
+            TicTacToeGameAI::BIG_BOARD_SIZE,
+            std::vector< bool >( TicTacToeGameAI::BIG_BOARD_SIZE, true ) );
+        for ( size_t i = 0; i < games; ++i )
+        {
+            sessions.emplace_back(
+                new Game( server, results, server.create_game( available ), i ) );
+        }
+        for ( auto& game : sessions )
+        {
+            server.get_my_move( game->id,
+                                [&game]( MovePosition move ) { game->on_my_move( move ); } );
+        }
+
+        std::unique_lock< std::mutex > lock( results.mutex );
+        results.finished.wait( lock, [&results]( ) { return results.games_left == 0; } );
+    }
+    auto const elapsed = std::chrono::duration< double >( Clock::now( ) - start ).count( );
+
+    auto& latencies = results.latencies;
+    std::sort( latencies.begin( ), latencies.end( ) );
+    std::cout << games << " games, " << settings.threads << " threads, " << latencies.size( )
+              << " moves in " << elapsed << " s, " << latencies.size( ) / elapsed
+              << " moves/s\nlatency p50 " << get_percentile( latencies, 0.5 ).count( )
+              << " us, p99 " << get_percentile( latencies, 0.99 ).count( ) << " us, max "
+              << latencies.back( ).count( ) << " us" << std::endl;
+}
@@ -0,0 +1,302 @@
+#include "MatchServer.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace mcts
+{
+namespace
+{
+// A search of a fixed number of iterations creates at most one node per iteration, so a larger
+// table only costs memory across many games. A timed search keeps the size it asked for.
+size_t
+get_transposition_table_size( const SearchSettings& settings )
+{
+    auto size = settings.transposition_table_size;
+    if ( settings.max_nodes > 0 )
+    {
+        size = std::min( size, settings.max_nodes );
+    }
+    if ( settings.time_budget == std::chrono::milliseconds::zero( ) && settings.iterations > 0 )
+    {
+        size = std::min( size, settings.iterations );
+    }
+    return size;
+}
+
+bool
+is_on_board( const MovePosition& position, int board_size )
+{
+    return position.row >= 0 && position.row < board_size && position.col >= 0
+           && position.col < board_size;
+}
+
+}  // namespace
+
+struct MatchServer::Session
+{
+    Session( std::unique_ptr< MctsSearch > search, const SearchSettings& settings, int board_size )
+        : search( std::move( search ) )
+        , settings( settings )
+        , board_size( board_size )
+        , ended( false )
+        , searching( false )
+        , my_move{-1, -1}
+        , opponent_move( -1 )
+        , iterations( 0 )
+    {
+    }
+
+    const std::unique_ptr< MctsSearch > search;
+    const SearchSettings settings;
+    const int board_size;
+    // Stops the running slice
+    std::atomic< bool > ended;
+
+    // Guarded by the mutex
+    std::mutex mutex;
+    bool searching;
+    MovePosition my_move;
+    std::vector< MoveCallback > waiting;
+
+    // Owned by the slices of the running search
+    // Played by the first slice, -1 when the AI moves first
+    Move opponent_move;
+    size_t iterations;
+    Clock::time_point deadline;
+};
+
+MatchServer::MatchServer( const MatchSettings& settings )
+    : m_settings( settings )
+    , m_next_game( 0 )
+    , m_pool( settings.threads )
+{
+}
+
+MatchServer::~MatchServer( )
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    for ( auto const& session : m_sessions )
+    {
+        session.second->ended.store( true, std::memory_order_relaxed );
+    }
+}
+
+GameId
+MatchServer::create_game( const AvailableCells& available )
+{
+    return create_game( available, m_settings.search );
+}
+
+GameId
+MatchServer::create_game( const AvailableCells& available, const SearchSettings& settings )
+{
+    GameId game;
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        game = m_next_game++;
+    }
+
+    // Games get different random streams from one seed
+    auto game_settings = settings;
+    game_settings.threads = 1;
+    game_settings.ponder = false;
+    game_settings.seed = settings.seed + game;
+    game_settings.transposition_table_size = m_settings.transposition_table_size > 0
+                                                 ? m_settings.transposition_table_size
+                                                 : get_transposition_table_size( settings );
+
+    auto const session = std::make_shared< Session >(
+        TicTacToeGameAI::create_search( available, game_settings ), game_settings,
+        static_cast< int >( available.size( ) ) );
+    {
+        std::lock_guard< std::mutex > lock( session->mutex );
+        start_search( session );
+    }
+
+    std::lock_guard< std::mutex > lock( m_mutex );
+    m_sessions.emplace( game, session );
+    return game;
+}
+
+void
+MatchServer::end_game( GameId game )
+{
+    SessionPtr session;
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        auto const it = m_sessions.find( game );
+        if ( it == m_sessions.end( ) )
+        {
+            return;
+        }
+        session = std::move( it->second );
+        m_sessions.erase( it );
+    }
+    session->ended.store( true, std::memory_order_relaxed );
+}
+
+bool
+MatchServer::opponent_move( GameId game, const MovePosition& position, MoveCallback callback )
+{
+    auto const session = find_session( game );
+    if ( !session )
+    {
+        return false;
+    }
+
+    // The search is only read while no slice of it runs
+    std::lock_guard< std::mutex > lock( session->mutex );
+    if ( session->searching || !is_on_board( position, session->board_size )
+         || !session->search->is_legal( position.row * session->board_size + position.col ) )
+    {
+        return false;
+    }
+
+    session->opponent_move = position.row * session->board_size + position.col;
+    session->waiting.push_back( std::move( callback ) );
+    start_search( session );
+    return true;
+}
+
+bool
+MatchServer::get_my_move( GameId game, MoveCallback callback )
+{
+    auto const session = find_session( game );
+    if ( !session )
+    {
+        return false;
+    }
+
+    MovePosition move;
+    {
+        std::lock_guard< std::mutex > lock( session->mutex );
+        if ( session->searching )
+        {
+            session->waiting.push_back( std::move( callback ) );
+            return true;
+        }
+        move = session->my_move;
+    }
+
+    callback( move );
+    return true;
+}
+
+std::future< MovePosition >
+MatchServer::opponent_move( GameId game, const MovePosition& position )
+{
+    return make_future( [this, game, &position]( MoveCallback callback ) {
+        return opponent_move( game, position, std::move( callback ) );
+    } );
+}
+
+std::future< MovePosition >
+MatchServer::get_my_move( GameId game )
+{
+    return make_future( [this, game]( MoveCallback callback ) {
+        return get_my_move( game, std::move( callback ) );
+    } );
+}
+
+size_t
+MatchServer::get_game_count( ) const
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    return m_sessions.size( );
+}
+
+MatchServer::SessionPtr
+MatchServer::find_session( GameId game ) const
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    auto const it = m_sessions.find( game );
+    return it == m_sessions.end( ) ? nullptr : it->second;
+}
+
+void
+MatchServer::start_search( const SessionPtr& session )
+{
+    session->searching = true;
+    session->iterations = 0;
+    session->deadline = session->settings.time_budget > std::chrono::milliseconds::zero( )
+                            ? Clock::now( ) + session->settings.time_budget
+                            : Clock::time_point::max( );
+    m_pool.submit( [this, session]( ) { run_slice( session ); } );
+}
+
+void
+MatchServer::run_slice( const SessionPtr& session )
+{
+    auto& s = *session;
+    if ( s.opponent_move >= 0 )
+    {
+        s.search->play_move( s.opponent_move );
+        s.opponent_move = -1;
+    }
+
+    // Every slice completes at least one iteration, so the current position is expanded
+    auto const timed = s.deadline != Clock::time_point::max( );
+    auto const iterations = timed ? std::numeric_limits< size_t >::max( )
+                                  : s.settings.iterations - std::min( s.iterations,
+                                                                      s.settings.iterations );
+    s.iterations += s.search->search( iterations,
+                                      std::min( Clock::now( ) + m_settings.time_slice, s.deadline ),
+                                      s.ended );
+
+    // A book answer, a solved position or a finished game do not get any more iterations
+    auto const& statistics = s.search->get_statistics( );
+    auto const finished = s.ended.load( std::memory_order_relaxed ) || statistics.from_book
+                          || statistics.solved || s.search->is_finished( )
+                          || ( timed ? Clock::now( ) >= s.deadline
+                                     : s.iterations >= s.settings.iterations );
+    if ( finished )
+    {
+        finish_search( s );
+    }
+    else
+    {
+        m_pool.submit( [this, session]( ) { run_slice( session ); } );
+    }
+}
+
+void
+MatchServer::finish_search( Session& session )
+{
+    MovePosition move{-1, -1};
+    auto const best
+        = session.ended.load( std::memory_order_relaxed ) ? -1 : session.search->get_best_move( );
+    if ( best >= 0 )
+    {
+        move = {best / session.board_size, best % session.board_size};
+        session.search->play_move( best );
+    }
+
+    std::vector< MoveCallback > waiting;
+    {
+        std::lock_guard< std::mutex > lock( session.mutex );
+        session.my_move = move;
+        session.searching = false;
+        waiting.swap( session.waiting );
+    }
+
+    for ( auto const& callback : waiting )
+    {
+        callback( move );
+    }
+}
+
+std::future< MovePosition >
+MatchServer::make_future( const std::function< bool( MoveCallback ) >& request )
+{
+    auto const promise = std::make_shared< std::promise< MovePosition > >( );
+    if ( !request( [promise]( MovePosition move ) { promise->set_value( move ); } ) )
+    {
+        promise->set_exception( std::make_exception_ptr(
+            std::invalid_argument( "unknown game, illegal move or the AI is still searching" ) ) );
+    }
+    return promise->get_future( );
+}
+
+}  // namespace mcts
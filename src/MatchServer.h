@@ -0,0 +1,93 @@
+#pragma once
+
+#include "TicTacToeGameAi.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mcts
+{
+using GameId = uint64_t;
+
+struct MatchSettings
+{
+    // Pool threads shared by all games
+    size_t threads = std::max( std::thread::hardware_concurrency( ), 1u );
+    // Settings of games created without their own. Every game searches on one pool thread at a
+    // time, pondering is not supported.
+    SearchSettings search;
+    // Longest a game searches before the thread moves on to the next waiting game
+    std::chrono::microseconds time_slice = std::chrono::microseconds( 2000 );
+    // Entries of the transposition table of every game. Zero sizes it from the node cap or the
+    // iterations of the game, never above its own transposition_table_size.
+    size_t transposition_table_size = 0;
+};
+
+// Plays many games at once on one shared thread pool. Every search is cut into time slices and
+// each slice is queued behind the slices of all other games, so a long search does not hold up
+// the replies of the others. A time budget counts from the request, including the time it waits
+// for a thread. Requests return at once, the AI move is delivered by a callback on a pool thread
+// or through a future. A move of {-1, -1} means the game is finished or was ended.
+struct MatchServer
+{
+    using AvailableCells = TicTacToeGameAI::AvailableCells;
+    using MoveCallback = std::function< void( MovePosition ) >;
+    using Clock = std::chrono::steady_clock;
+
+    explicit MatchServer( const MatchSettings& settings );
+    // Stops all searches, pending requests are dropped
+    ~MatchServer( );
+
+    MatchServer( const MatchServer& ) = delete;
+    MatchServer& operator=( const MatchServer& ) = delete;
+
+    // Starts a game where the AI moves first, with the server settings or its own
+    GameId create_game( const AvailableCells& available );
+    GameId create_game( const AvailableCells& available, const SearchSettings& settings );
+    // Stops its search, a pending request is answered with {-1, -1}
+    void end_game( GameId game );
+
+    // Plays the opponent move and searches the reply. False when the game is unknown, the move is
+    // not legal in the current position or the AI did not reply to the previous move yet.
+    bool opponent_move( GameId game, const MovePosition& position, MoveCallback callback );
+    // Current AI move, called at once unless the AI is still searching. False when the game is
+    // unknown.
+    bool get_my_move( GameId game, MoveCallback callback );
+
+    // A rejected request holds std::invalid_argument
+    std::future< MovePosition > opponent_move( GameId game, const MovePosition& position );
+    std::future< MovePosition > get_my_move( GameId game );
+
+    size_t get_game_count( ) const;
+
+private:
+    struct Session;
+    using SessionPtr = std::shared_ptr< Session >;
+
+    SessionPtr find_session( GameId game ) const;
+    // Queues the first slice of a search, the session lock must be held
+    void start_search( const SessionPtr& session );
+    void run_slice( const SessionPtr& session );
+    void finish_search( Session& session );
+
+    static std::future< MovePosition > make_future(
+        const std::function< bool( MoveCallback ) >& request );
+
+private:
+    const MatchSettings m_settings;
+    mutable std::mutex m_mutex;
+    std::unordered_map< GameId, SessionPtr > m_sessions;
+    GameId m_next_game;
+    // Destroyed first, no slice runs once the other members are gone
+    ThreadPool m_pool;
+};
+
+}  // namespace mcts
@@ -0,0 +1,653 @@
+#pragma once
+
+#include "MctsNode.h"
+#include "SlabPool.h"
+#include "TranspositionTable.h"
+#include "TreeSnapshot.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace mcts
+{
+// Search tree over positions of `Game`, which is resolved at compile time so the whole selection
+// and playout loop can be inlined. A game provides
+//
+//     struct Game
+//     {
+//         // Position, copied for every child
+//         using State = ...;
+//         // Legal moves of one position, with begin( ), end( ), size( ), operator[ ] and
+//         // push_back( )
+//         using Moves = ...;
+//
+//         static void get_moves( const State& state, Moves& moves );
+//         static void play( State& state, Move move );
+//         // Result of a playout from `state`, from the point of view of the side the search
+//         // started for. A position without moves is finished and returns its result.
+//         static MctsState::Result simulate( const State& state, RandomEngine& random );
+//         // True when the side the search started for is to move
+//         static bool is_my_turn( const State& state );
+//         // Equal for the same position reached by different move orders
+//         static Hash get_hash( const State& state );
+//     };
+//
+// Owns all nodes of one search tree. Nodes, edges and edge statistics live in slab pools and
+// link to each other with raw pointers, the whole tree is released at once together with the
+// pools. Once a move is played the tree is re-rooted: the part that is still reachable is moved
+// to fresh pools and the old pools, with every discarded node, are freed in bulk.
+// Only the position of the root is stored, every iteration replays the moves of its path.
+// Positions reached by different move orders share one node through the transposition table,
+// which turns the tree into a directed acyclic graph.
+// The number of nodes may be capped. A full tree stops expanding and keeps running playouts from
+// its leaves until it is re-rooted or recycled.
+// A tree can be copied to a TreeSnapshot and restored from one, which needs a State that is
+// trivially copyable.
+template < typename Game >
+struct Mcts
+{
+    using State = typename Game::State;
+    using Node = BasicMctsNode< Game >;
+    using NodePtr = Node*;
+
+    explicit Mcts( State state, size_t transposition_table_size = 0, size_t max_nodes = 0 );
+
+    Mcts( const Mcts& ) = delete;
+    Mcts& operator=( const Mcts& ) = delete;
+
+    // Runs one iteration from the root with `playouts` playouts from the selected leaf and
+    // returns the depth of that leaf. The phases are timed when `times` is given.
+    int choose_child( RandomEngine& random,
+                      int virtual_loss = 0,
+                      int playouts = 1,
+                      MctsPhaseTimes* times = nullptr );
+    // Runs one iteration per element of `leaves`. All leaves are selected first, then their
+    // playouts run back to back and finally all results are back-propagated. Without a
+    // positive virtual loss the leaves of one batch are mostly the same.
+    void choose_children( RandomEngine& random,
+                          typename Node::Leaves& leaves,
+                          int virtual_loss,
+                          int playouts = 1,
+                          MctsPhaseTimes* times = nullptr );
+    NodePtr get_root( ) const;
+    // True once the value of the root is proven, further iterations change nothing
+    bool is_solved( ) const;
+    // Position of the root
+    const State& get_state( ) const;
+    // Links `parent` to the positions after `moves`, in that order, without creating their nodes
+    void create_children( Node& parent, const typename Game::Moves& moves );
+    // Node of the child of `parent` at `index`, whose position is `state`. Created once for all
+    // threads, null when the tree is full.
+    NodePtr create_child( Node& parent, int index, const State& state );
+    size_t get_node_count( ) const;
+    // True once the node cap is reached, a few concurrent expansions may still exceed it
+    bool is_full( ) const;
+    // Bytes reserved for nodes, edges and statistics, without the transposition table
+    size_t get_memory_usage( ) const;
+    // Bytes of the transposition table, which does not grow with the tree
+    size_t get_transposition_memory_usage( ) const;
+    // Makes the position after `move` the root, must not run concurrently with a search
+    void reroot( Move move );
+    // Collapses the least visited subtrees into unproven leaves until at most `max_nodes` nodes
+    // are left, keeping the children of the root. Must not run concurrently with a search.
+    void recycle( size_t max_nodes );
+    // Copies the position and all nodes to `snapshot`, must not run concurrently with a search
+    void save( TreeSnapshot::Tree& snapshot ) const;
+    // Replaces the position and all nodes with those of `snapshot`. The nodes, edges and
+    // statistics are each created in a single allocation. Must not run concurrently with a
+    // search.
+    void restore( const TreeSnapshot::TreeView& snapshot );
+
+private:
+    using Edge = typename Node::Edge;
+    using MovedNodes = std::unordered_map< NodePtr, NodePtr >;
+    using Clock = std::chrono::steady_clock;
+
+    struct Pools
+    {
+        SlabPool< Node > nodes;
+        SlabPool< Edge > edges;
+        SlabPool< std::atomic< int > > statistics;
+    };
+
+    static NodePtr create_node( SlabPool< Node >& nodes );
+    static std::atomic< int >* create_statistics( SlabPool< std::atomic< int > >& statistics,
+                                                  int children_count );
+    // Fewest trials a node needs to keep its children when at most `max_nodes` nodes are kept
+    int get_recycle_threshold( size_t max_nodes ) const;
+    // Moves the subtree of `node` at position `state` to fresh pools and makes it the root, a
+    // null `node` starts an empty tree. Nodes with fewer than `min_trials` trials lose their
+    // children.
+    void rebuild( NodePtr node, State state, int min_trials );
+    NodePtr move_node( Pools& pools,
+                       MovedNodes& moved,
+                       Node& source,
+                       const State& state,
+                       int min_trials );
+    // Appends `node` at position `state` and its unsaved descendants in preorder, returns its
+    // preorder index
+    static int32_t save_node( TreeSnapshot::Tree& snapshot,
+                              std::unordered_map< const Node*, int32_t >& saved,
+                              const Node& node,
+                              const State& state );
+
+private:
+    const size_t m_max_nodes;
+    State m_state;
+    Pools m_pools;
+    TranspositionTable< Node > m_transpositions;
+    // Serializes the creation of children, so every edge gets a single node
+    std::mutex m_children_mutex;
+    NodePtr m_root;
+};
+
+template < typename Game >
+Mcts< Game >::Mcts( State state, size_t transposition_table_size, size_t max_nodes )
+    : m_max_nodes( max_nodes )
+    , m_state( std::move( state ) )
+    , m_transpositions( transposition_table_size )
+    , m_root( create_node( m_pools.nodes ) )
+{
+}
+
+template < typename Game >
+int
+Mcts< Game >::choose_child( RandomEngine& random,
+                            int virtual_loss /*= 0 */,
+                            int playouts /*= 1 */,
+                            MctsPhaseTimes* times /*= nullptr */ )
+{
+    // Reused by all iterations of a thread
+    static thread_local typename Node::Leaf leaf;
+
+    if ( !times )
+    {
+        m_root->select_leaf( *this, m_state, random, virtual_loss, leaf, nullptr );
+        Node::evaluate( leaf, random, playouts );
+        Node::backpropagate( leaf, virtual_loss );
+        return static_cast< int >( leaf.path.size( ) ) - 1;
+    }
+
+    // Expansion is timed on its own and not counted as selection
+    auto const expansion = times->expansion;
+    auto const start = Clock::now( );
+    m_root->select_leaf( *this, m_state, random, virtual_loss, leaf, times );
+    auto const selected = Clock::now( );
+    Node::evaluate( leaf, random, playouts );
+    auto const evaluated = Clock::now( );
+    Node::backpropagate( leaf, virtual_loss );
+    auto const end = Clock::now( );
+
+    times->selection += selected - start - ( times->expansion - expansion );
+    times->simulation += evaluated - selected;
+    times->backpropagation += end - evaluated;
+    return static_cast< int >( leaf.path.size( ) ) - 1;
+}
+
+template < typename Game >
+void
+Mcts< Game >::choose_children( RandomEngine& random,
+                               typename Node::Leaves& leaves,
+                               int virtual_loss,
+                               int playouts /*= 1 */,
+                               MctsPhaseTimes* times /*= nullptr */ )
+{
+    auto const expansion = times ? times->expansion : std::chrono::nanoseconds::zero( );
+    auto const start = times ? Clock::now( ) : Clock::time_point( );
+    for ( auto& leaf : leaves )
+    {
+        m_root->select_leaf( *this, m_state, random, virtual_loss, leaf, times );
+    }
+
+    auto const selected = times ? Clock::now( ) : Clock::time_point( );
+    for ( auto& leaf : leaves )
+    {
+        Node::evaluate( leaf, random, playouts );
+    }
+
+    auto const evaluated = times ? Clock::now( ) : Clock::time_point( );
+    for ( auto const& leaf : leaves )
+    {
+        Node::backpropagate( leaf, virtual_loss );
+    }
+
+    if ( times )
+    {
+        auto const end = Clock::now( );
+        times->selection += selected - start - ( times->expansion - expansion );
+        times->simulation += evaluated - selected;
+        times->backpropagation += end - evaluated;
+    }
+}
+
+template < typename Game >
+typename Mcts< Game >::NodePtr
+Mcts< Game >::get_root( ) const
+{
+    return m_root;
+}
+
+template < typename Game >
+bool
+Mcts< Game >::is_solved( ) const
+{
+    return m_root->get_proof( ) != Proof::e_Proof_None;
+}
+
+template < typename Game >
+const typename Mcts< Game >::State&
+Mcts< Game >::get_state( ) const
+{
+    return m_state;
+}
+
+template < typename Game >
+void
+Mcts< Game >::create_children( Node& parent, const typename Game::Moves& moves )
+{
+    auto const count = moves.size( );
+    if ( count == 0 )
+    {
+        return;
+    }
+
+    parent.m_children = m_pools.edges.create(
+        count, [&moves]( Edge* place, size_t index ) { new ( place ) Edge( moves[ index ] ); } );
+    parent.m_children_count = static_cast< int >( count );
+    parent.m_child_statistics = create_statistics( m_pools.statistics, parent.m_children_count );
+}
+
+template < typename Game >
+typename Mcts< Game >::NodePtr
+Mcts< Game >::create_child( Node& parent, int index, const State& state )
+{
+    if ( is_full( ) )
+    {
+        return nullptr;
+    }
+
+    auto const hash = m_transpositions.is_enabled( ) ? Game::get_hash( state ) : Hash( );
+    auto& edge = parent.m_children[ index ];
+
+    std::lock_guard< std::mutex > lock( m_children_mutex );
+
+    // Another thread may have created it in the meantime, a known position is shared
+    auto child = edge.node.load( std::memory_order_relaxed );
+    if ( !child && m_transpositions.is_enabled( ) )
+    {
+        child = m_transpositions.find( hash );
+    }
+    if ( !child )
+    {
+        child = create_node( m_pools.nodes );
+        if ( m_transpositions.is_enabled( ) )
+        {
+            m_transpositions.insert( hash, child );
+        }
+    }
+    edge.node.store( child, std::memory_order_release );
+    return child;
+}
+
+template < typename Game >
+size_t
+Mcts< Game >::get_node_count( ) const
+{
+    return m_pools.nodes.size( );
+}
+
+template < typename Game >
+bool
+Mcts< Game >::is_full( ) const
+{
+    return m_max_nodes > 0 && m_pools.nodes.size( ) >= m_max_nodes;
+}
+
+template < typename Game >
+size_t
+Mcts< Game >::get_memory_usage( ) const
+{
+    return m_pools.nodes.get_memory_usage( ) + m_pools.edges.get_memory_usage( )
+           + m_pools.statistics.get_memory_usage( );
+}
+
+template < typename Game >
+size_t
+Mcts< Game >::get_transposition_memory_usage( ) const
+{
+    return m_transpositions.get_memory_usage( );
+}
+
+template < typename Game >
+void
+Mcts< Game >::reroot( Move move )
+{
+    auto state = m_state;
+    Game::play( state, move );
+    rebuild( m_root->find_child( move ), std::move( state ), 0 );
+}
+
+template < typename Game >
+void
+Mcts< Game >::recycle( size_t max_nodes )
+{
+    auto const min_trials = get_recycle_threshold( max_nodes );
+    if ( min_trials > 0 )
+    {
+        rebuild( m_root, m_state, std::min( min_trials, m_root->get_total_trials( ) ) );
+    }
+}
+
+template < typename Game >
+int
+Mcts< Game >::get_recycle_threshold( size_t max_nodes ) const
+{
+    // Trials and number of child nodes of every reachable expanded node
+    std::vector< std::pair< int, int > > expanded;
+    std::unordered_set< const Node* > visited{m_root};
+    std::vector< const Node* > pending{m_root};
+    while ( !pending.empty( ) )
+    {
+        auto const node = pending.back( );
+        pending.pop_back( );
+        if ( !node->is_expanded( ) || node->m_children_count == 0 )
+        {
+            continue;
+        }
+
+        int children = 0;
+        for ( int i = 0; i < node->m_children_count; ++i )
+        {
+            auto const child = node->m_children[ i ].node.load( std::memory_order_relaxed );
+            if ( child )
+            {
+                ++children;
+                if ( visited.insert( child ).second )
+                {
+                    pending.push_back( child );
+                }
+            }
+        }
+        expanded.emplace_back( node->get_total_trials( ), children );
+    }
+
+    // The most visited nodes keep their children while they fit, transposed children are
+    // counted once per parent so the estimate never falls short
+    std::sort( expanded.begin( ), expanded.end( ),
+               []( const std::pair< int, int >& lhs, const std::pair< int, int >& rhs ) {
+                   return lhs.first > rhs.first;
+               } );
+    size_t nodes = 1;
+    for ( auto const& node : expanded )
+    {
+        nodes += node.second;
+        if ( nodes > max_nodes )
+        {
+            return node.first + 1;
+        }
+    }
+    return 0;
+}
+
+template < typename Game >
+void
+Mcts< Game >::rebuild( NodePtr node, State state, int min_trials )
+{
+    // Entries of released nodes are dropped, moved nodes are inserted again
+    if ( m_transpositions.is_enabled( ) )
+    {
+        m_transpositions.clear( );
+    }
+
+    Pools pools;
+    MovedNodes moved;
+    auto root = node ? move_node( pools, moved, *node, state, min_trials )
+                     : create_node( pools.nodes );
+
+    m_pools.nodes.swap( pools.nodes );
+    m_pools.edges.swap( pools.edges );
+    m_pools.statistics.swap( pools.statistics );
+    m_state = std::move( state );
+    m_root = root;
+}
+
+template < typename Game >
+typename Mcts< Game >::NodePtr
+Mcts< Game >::create_node( SlabPool< Node >& nodes )
+{
+    return nodes.create( 1, []( Node* place, size_t ) { new ( place ) Node( ); } );
+}
+
+template < typename Game >
+std::atomic< int >*
+Mcts< Game >::create_statistics( SlabPool< std::atomic< int > >& statistics, int children_count )
+{
+    // Hits, trials and proofs of one node are allocated together
+    return statistics.create( 3 * children_count, []( std::atomic< int >* place, size_t ) {
+        new ( place ) std::atomic< int >( 0 );
+    } );
+}
+
+template < typename Game >
+typename Mcts< Game >::NodePtr
+Mcts< Game >::move_node( Pools& pools,
+                         MovedNodes& moved,
+                         Node& source,
+                         const State& state,
+                         int min_trials )
+{
+    auto const moved_node = moved.find( &source );
+    if ( moved_node != moved.end( ) )
+    {
+        return moved_node->second;
+    }
+
+    auto target = create_node( pools.nodes );
+    moved.emplace( &source, target );
+    if ( m_transpositions.is_enabled( ) )
+    {
+        m_transpositions.insert( Game::get_hash( state ), target );
+    }
+
+    target->m_total_trials.store( source.get_total_trials( ), std::memory_order_relaxed );
+
+    // A collapsed node is expanded again the next time it is selected. It loses its proof with
+    // its children and is proven again from them, so it is searched once it becomes the root.
+    if ( !source.is_expanded( ) || source.get_total_trials( ) < min_trials )
+    {
+        return target;
+    }
+    target->m_proof.store( source.get_proof( ), std::memory_order_relaxed );
+
+    if ( source.m_children_count > 0 )
+    {
+        target->m_children = pools.edges.create(
+            source.m_children_count, [&source]( Edge* place, size_t index ) {
+                new ( place ) Edge( source.m_children[ index ].move );
+            } );
+        target->m_children_count = source.m_children_count;
+        target->m_explored_count.store(
+            source.m_explored_count.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+
+        target->m_child_statistics
+            = create_statistics( pools.statistics, source.m_children_count );
+        for ( int i = 0; i < 3 * source.m_children_count; ++i )
+        {
+            target->m_child_statistics[ i ].store(
+                source.m_child_statistics[ i ].load( std::memory_order_relaxed ),
+                std::memory_order_relaxed );
+        }
+
+        // Children that were never visited stay without a node
+        for ( int i = 0; i < source.m_children_count; ++i )
+        {
+            auto const child = source.m_children[ i ].node.load( std::memory_order_relaxed );
+            if ( child )
+            {
+                auto child_state = state;
+                Game::play( child_state, source.m_children[ i ].move );
+                target->m_children[ i ].node.store(
+                    move_node( pools, moved, *child, child_state, min_trials ),
+                    std::memory_order_relaxed );
+            }
+        }
+    }
+    target->m_expansion.store( Node::Expansion::e_Expansion_Done, std::memory_order_release );
+
+    return target;
+}
+
+template < typename Game >
+void
+Mcts< Game >::save( TreeSnapshot::Tree& snapshot ) const
+{
+    static_assert( std::is_trivially_copyable< State >::value,
+                   "the position is saved as its bytes" );
+
+    snapshot.state.resize( sizeof( State ) );
+    std::memcpy( snapshot.state.data( ), &m_state, sizeof( State ) );
+    snapshot.nodes.clear( );
+    snapshot.edges.clear( );
+
+    std::unordered_map< const Node*, int32_t > saved;
+    save_node( snapshot, saved, *m_root, m_state );
+}
+
+template < typename Game >
+void
+Mcts< Game >::restore( const TreeSnapshot::TreeView& snapshot )
+{
+    static_assert( std::is_trivially_copyable< State >::value,
+                   "the position is restored from its bytes" );
+
+    if ( m_transpositions.is_enabled( ) )
+    {
+        m_transpositions.clear( );
+    }
+
+    // Children are linked by preorder index, so every node exists before the edges are created
+    Pools pools;
+    auto const nodes = pools.nodes.create(
+        snapshot.node_count, []( Node* place, size_t ) { new ( place ) Node( ); } );
+    Edge* edges = nullptr;
+    std::atomic< int >* statistics = nullptr;
+    if ( snapshot.edge_count > 0 )
+    {
+        edges = pools.edges.create( snapshot.edge_count, [&snapshot, nodes]( Edge* place,
+                                                                            size_t index ) {
+            auto const& edge = snapshot.edges[ index ];
+            new ( place ) Edge( edge.move );
+            place->node.store( edge.node >= 0 ? nodes + edge.node : nullptr,
+                               std::memory_order_relaxed );
+        } );
+        statistics = create_statistics( pools.statistics,
+                                        static_cast< int >( snapshot.edge_count ) );
+    }
+
+    size_t first_edge = 0;
+    for ( size_t i = 0; i < snapshot.node_count; ++i )
+    {
+        auto const& record = snapshot.nodes[ i ];
+        auto& node = nodes[ i ];
+        node.m_total_trials.store( record.total_trials, std::memory_order_relaxed );
+        node.m_proof.store( static_cast< Proof >( record.proof ), std::memory_order_relaxed );
+        if ( m_transpositions.is_enabled( ) )
+        {
+            m_transpositions.insert( record.hash, &node );
+        }
+        if ( record.children_count < 0 )
+        {
+            continue;
+        }
+
+        if ( record.children_count > 0 )
+        {
+            node.m_children = edges + first_edge;
+            node.m_children_count = record.children_count;
+            node.m_explored_count.store( record.explored_count, std::memory_order_relaxed );
+            node.m_child_statistics = statistics + 3 * first_edge;
+            for ( int child = 0; child < record.children_count; ++child )
+            {
+                auto const& edge = snapshot.edges[ first_edge + child ];
+                node.get_child_hits( )[ child ].store( edge.hits, std::memory_order_relaxed );
+                node.get_child_trials( )[ child ].store( edge.trials, std::memory_order_relaxed );
+                // Parents learn the proofs of their children from the children
+                node.get_child_proofs( )[ child ].store(
+                    edge.node >= 0 ? snapshot.nodes[ edge.node ].proof : 0,
+                    std::memory_order_relaxed );
+            }
+            first_edge += record.children_count;
+        }
+        node.m_expansion.store( Node::Expansion::e_Expansion_Done, std::memory_order_release );
+    }
+
+    m_pools.nodes.swap( pools.nodes );
+    m_pools.edges.swap( pools.edges );
+    m_pools.statistics.swap( pools.statistics );
+    std::memcpy( &m_state, snapshot.state, sizeof( State ) );
+    m_root = nodes;
+}
+
+template < typename Game >
+int32_t
+Mcts< Game >::save_node( TreeSnapshot::Tree& snapshot,
+                         std::unordered_map< const Node*, int32_t >& saved,
+                         const Node& node,
+                         const State& state )
+{
+    auto const index = static_cast< int32_t >( snapshot.nodes.size( ) );
+    saved.emplace( &node, index );
+
+    auto const expanded = node.is_expanded( );
+    snapshot.nodes.push_back( {Game::get_hash( state ), node.get_total_trials( ),
+                               expanded ? node.m_children_count : -1,
+                               node.m_explored_count.load( std::memory_order_relaxed ),
+                               static_cast< int32_t >( node.get_proof( ) )} );
+    if ( !expanded )
+    {
+        return index;
+    }
+
+    // The edges of a node are reserved before its descendants are appended
+    auto const first_edge = snapshot.edges.size( );
+    auto const hits = node.get_child_hits( );
+    auto const trials = node.get_child_trials( );
+    for ( int i = 0; i < node.m_children_count; ++i )
+    {
+        snapshot.edges.push_back( {node.m_children[ i ].move,
+                                   hits[ i ].load( std::memory_order_relaxed ),
+                                   trials[ i ].load( std::memory_order_relaxed ), -1} );
+    }
+
+    for ( int i = 0; i < node.m_children_count; ++i )
+    {
+        auto const child = node.m_children[ i ].node.load( std::memory_order_relaxed );
+        if ( !child )
+        {
+            continue;
+        }
+
+        auto const saved_child = saved.find( child );
+        if ( saved_child != saved.end( ) )
+        {
+            snapshot.edges[ first_edge + i ].node = saved_child->second;
+            continue;
+        }
+
+        // Appending the descendants may reallocate the edges
+        auto child_state = state;
+        Game::play( child_state, node.m_children[ i ].move );
+        auto const child_index = save_node( snapshot, saved, *child, child_state );
+        snapshot.edges[ first_edge + i ].node = child_index;
+    }
+    return index;
+}
+
+}  // namespace mcts
@@ -0,0 +1,218 @@
+#include "GameState.h"
+#include "Mcts.h"
+#include "TicTacToeBigGame.h"
+#include "TicTacToeGameAi.h"
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+using namespace mcts;
+
+// All benchmarks start from positions and generators derived from this seed
+const uint64_t SEED = 42;
+
+template < typename Game >
+typename Game::State get_start_state( );
+
+template <>
+TicTacToeGame::State
+get_start_state< TicTacToeGame >( )
+{
+    return TicTacToeGame::make_state( 0, 0, true );
+}
+
+template <>
+TicTacToeBigGame::State
+get_start_state< TicTacToeBigGame >( )
+{
+    return TicTacToeBigGame::make_state( TicTacToeBigGame::Boards{}, TicTacToeBigGame::Boards{},
+                                         true );
+}
+
+template <>
+TacticalTicTacToeBigGame::State
+get_start_state< TacticalTicTacToeBigGame >( )
+{
+    return get_start_state< TicTacToeBigGame >( );
+}
+
+// Position after up to `moves` random moves, stops early when the game is finished
+template < typename Game >
+typename Game::State
+get_random_state( int moves )
+{
+    RandomEngine random( SEED );
+    auto state = get_start_state< Game >( );
+    for ( int i = 0; i < moves; ++i )
+    {
+        typename Game::Moves legal_moves;
+        Game::get_moves( state, legal_moves );
+        if ( legal_moves.size( ) == 0 )
+        {
+            break;
+        }
+        Game::play( state, legal_moves[ bounded( random, legal_moves.size( ) ) ] );
+    }
+    return state;
+}
+
+template < typename Game >
+void
+BM_Playout( benchmark::State& state )
+{
+    auto const start = get_start_state< Game >( );
+    RandomEngine random( SEED );
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize( Game::simulate( start, random ) );
+    }
+    state.SetItemsProcessed( state.iterations( ) );
+}
+BENCHMARK_TEMPLATE( BM_Playout, TicTacToeGame );
+BENCHMARK_TEMPLATE( BM_Playout, TicTacToeBigGame );
+BENCHMARK_TEMPLATE( BM_Playout, TacticalTicTacToeBigGame );
+
+// Children of the start position through the virtual MctsState interface
+template < typename Game >
+void
+BM_GetChildren( benchmark::State& state )
+{
+    GameState< Game > const start( get_start_state< Game >( ) );
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize( start.get_children( ) );
+    }
+    state.SetItemsProcessed( state.iterations( ) );
+}
+BENCHMARK_TEMPLATE( BM_GetChildren, TicTacToeGame );
+BENCHMARK_TEMPLATE( BM_GetChildren, TicTacToeBigGame );
+
+// Expansion of the start position the way the Mcts< Game > template does it, which only lists
+// the moves and creates the child nodes later
+template < typename Game >
+void
+BM_Expand( benchmark::State& state )
+{
+    auto const start = get_start_state< Game >( );
+    RandomEngine random( SEED );
+    for ( auto _ : state )
+    {
+        typename Game::Moves moves;
+        Game::get_moves( start, moves );
+        std::shuffle( moves.begin( ), moves.end( ), random );
+        benchmark::DoNotOptimize( moves );
+    }
+    state.SetItemsProcessed( state.iterations( ) );
+}
+BENCHMARK_TEMPLATE( BM_Expand, TicTacToeGame );
+BENCHMARK_TEMPLATE( BM_Expand, TicTacToeBigGame );
+
+// One move on a position after 30 random moves, including the update of the game result
+void
+BM_Play( benchmark::State& state )
+{
+    auto const position = get_random_state< TicTacToeBigGame >( 30 );
+    TicTacToeBigGame::Moves moves;
+    TicTacToeBigGame::get_moves( position, moves );
+    for ( auto _ : state )
+    {
+        auto child = position;
+        TicTacToeBigGame::play( child, moves[ 0 ] );
+        benchmark::DoNotOptimize( child );
+    }
+    state.SetItemsProcessed( state.iterations( ) );
+}
+BENCHMARK( BM_Play );
+
+// Single threaded search of `state.range( 0 )` iterations from the start position
+template < typename Game >
+void
+BM_Search( benchmark::State& state )
+{
+    auto const iterations = state.range( 0 );
+    size_t nodes = 0;
+    size_t bytes = 0;
+    for ( auto _ : state )
+    {
+        Mcts< Game > tree( get_start_state< Game >( ), SearchSettings( ).transposition_table_size );
+        RandomEngine random( SEED );
+        for ( int64_t i = 0; i < iterations; ++i )
+        {
+            tree.choose_child( random );
+        }
+        nodes += tree.get_node_count( );
+        bytes += tree.get_memory_usage( );
+    }
+    state.SetItemsProcessed( state.iterations( ) * iterations );
+    state.counters[ "nodes" ] = benchmark::Counter( static_cast< double >( nodes ),
+                                                    benchmark::Counter::kIsRate );
+    state.counters[ "bytes_per_node" ] = static_cast< double >( bytes ) / nodes;
+}
+BENCHMARK_TEMPLATE( BM_Search, TicTacToeGame )->Arg( 1000 )->Unit( benchmark::kMillisecond );
+BENCHMARK_TEMPLATE( BM_Search, TicTacToeBigGame )
+    ->Arg( 1000 )
+    ->Arg( 10000 )
+    ->Unit( benchmark::kMillisecond );
+
+// Restoring a saved tree of `state.range( 0 )` iterations from the start position of the big
+// board, without reading the file
+void
+BM_RestoreSnapshot( benchmark::State& state )
+{
+    auto const size = SearchSettings( ).transposition_table_size;
+    Mcts< TicTacToeBigGame > source( get_start_state< TicTacToeBigGame >( ), size );
+    RandomEngine random( SEED );
+    for ( int64_t i = 0; i < state.range( 0 ); ++i )
+    {
+        source.choose_child( random );
+    }
+
+    TreeSnapshot::Tree saved;
+    source.save( saved );
+    TreeSnapshot::TreeView const view{saved.state.data( ), saved.nodes.data( ),
+                                      saved.nodes.size( ), saved.edges.data( ),
+                                      saved.edges.size( )};
+
+    Mcts< TicTacToeBigGame > tree( get_start_state< TicTacToeBigGame >( ), size );
+    for ( auto _ : state )
+    {
+        tree.restore( view );
+        benchmark::DoNotOptimize( tree.get_root( ) );
+    }
+    state.SetItemsProcessed( state.iterations( ) * static_cast< int64_t >( saved.nodes.size( ) ) );
+}
+BENCHMARK( BM_RestoreSnapshot )->Arg( 10000 )->Arg( 100000 )->Unit( benchmark::kMillisecond );
+
+// First move of the AI on the empty big board, `state.range( 0 )` iterations on each of
+// `state.range( 1 )` threads, with root and tree parallelization
+void
+BM_TicTacToeGameAI( benchmark::State& state )
+{
+    TicTacToeGameAI::AvailableCells const available(
+        TicTacToeGameAI::BIG_BOARD_SIZE,
+        std::vector< bool >( TicTacToeGameAI::BIG_BOARD_SIZE, true ) );
+
+    SearchSettings settings;
+    settings.iterations = static_cast< size_t >( state.range( 0 ) );
+    settings.threads = static_cast< size_t >( state.range( 1 ) );
+    settings.parallelism = static_cast< Parallelism >( state.range( 2 ) );
+    settings.seed = SEED;
+
+    size_t iterations = 0;
+    for ( auto _ : state )
+    {
+        TicTacToeGameAI ai( available, settings );
+        iterations += ai.get_search_iterations( );
+    }
+    state.SetItemsProcessed( static_cast< int64_t >( iterations ) );
+}
+BENCHMARK( BM_TicTacToeGameAI )
+    ->ArgNames( {"iterations", "threads", "tree"} )
+    ->ArgsProduct( {{2000}, {1, 2, 4, 8}, {0, 1}} )
+    ->UseRealTime( )
+    ->Unit( benchmark::kMillisecond );
+
+}  // namespace
+
+BENCHMARK_MAIN( );
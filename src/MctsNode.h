@@ -1,34 +1,497 @@
 #pragma once
 
 #include "MctsState.h"
+#include "UcbSelection.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <functional>
-#include <memory>
+#include <vector>
 
 namespace mcts
 {
-struct MctsNode : public std::enable_shared_from_this< MctsNode >
+template < typename Game >
+struct Mcts;
+
+// Time spent in every phase of the iterations that were given these times to fill
+struct MctsPhaseTimes
 {
-    explicit MctsNode( std::unique_ptr< MctsState > state, MctsNodePtr parent = nullptr );
+    std::chrono::nanoseconds selection{0};
+    std::chrono::nanoseconds expansion{0};
+    std::chrono::nanoseconds simulation{0};
+    std::chrono::nanoseconds backpropagation{0};
+};
 
-    MctsNodePtr choose_child( );
-    MctsState const& get_state( ) const;
-    MctsNodePtr find_child( std::function< bool( const MctsState& ) > predicate ) const;
+// Game value of a position once the search proved it, from the point of view of the side the
+// search started for
+enum class Proof : uint8_t
+{
+    e_Proof_None = 0,
+    e_Proof_Hit,
+    e_Proof_Miss,
+    e_Proof_Draw,
+};
 
-private:
-    void run_simulation( );
-    MctsNodePtr explore_and_exploit( );
-    void back_propagate( MctsState::Result result );
-    double child_potential( const MctsNode& child ) const;
+// Every edge counts the hits of the side that plays its move, two per won playout and one per
+// draw, so each level of the tree maximizes the result of the side to move there like negamax.
+// Node statistics are updated lock-free, so several threads may run iterations on the same
+// tree. A positive virtual loss is added to every child on the way down and reverted once its
+// playout is back-propagated, which steers concurrent threads to different branches.
+// A node may be the child of several nodes when positions transpose, so every iteration records
+// the path it selected and back-propagates the result along that path.
+// Hits and trials are kept per edge by the parent in two contiguous arrays, so selecting a
+// child scans the arrays without touching the child nodes. Children are shuffled on expansion
+// and explored in that order, a counter tells how many of them were explored.
+// Nodes do not store their position. An expansion only lists the moves, the node of a child is
+// created the first time it is visited and positions are replayed from the root on the way down.
+// Finished positions are proven and proofs move up the path like in MCTS-Solver: a node is
+// proven once one child wins for the side to move or all children are proven. Every parent keeps
+// the proofs of its children next to their statistics, proven children are no longer selected
+// and a proven node reached by selection is evaluated by its proof instead of playouts.
+template < typename Game >
+struct BasicMctsNode
+{
+    using State = typename Game::State;
+    using Tree = Mcts< Game >;
+
+    struct Edge
+    {
+        explicit Edge( Move move )
+            : move( move )
+            , node( nullptr )
+        {
+        }
+
+        Move move;
+        // Null until the child is visited
+        std::atomic< BasicMctsNode* > node;
+    };
+
+    // One iteration between its selection and its back-propagation
+    struct Leaf
+    {
+        struct Step
+        {
+            // Null for a leaf that did not get a node, because the tree is full
+            BasicMctsNode* node;
+            // Index of the selected child, -1 for the leaf
+            int child;
+            // Side to move at the node
+            bool my_turn;
+        };
+
+        // From the root to the leaf
+        std::vector< Step > path;
+        // Position of the leaf
+        State state;
+        // Known value of the leaf, which then needs no playouts
+        Proof proof = Proof::e_Proof_None;
+        // Playout results from the leaf, hits and draws for the side the search started for
+        int hits = 0;
+        int draws = 0;
+        int trials = 0;
+    };
+
+    using Leaves = std::vector< Leaf >;
+
+    BasicMctsNode( );
+
+    // Null when the child with `move` was not visited yet
+    BasicMctsNode* find_child( Move move ) const;
+    // Visits the move, hits, trials and proof of every child
+    void visit_children( std::function< void( Move, int, int, Proof ) > visitor ) const;
+    // Trials of this position through all its parents
+    int get_total_trials( ) const;
+    Proof get_proof( ) const;
 
 private:
-    std::unique_ptr< MctsState > m_state;
-    std::weak_ptr< MctsNode > m_parent;
+    friend struct Mcts< Game >;
+
+    enum class Expansion : uint8_t
+    {
+        e_Expansion_None = 0,
+        e_Expansion_InProgress,
+        e_Expansion_Done,
+    };
 
-    int m_hits;
-    int m_total_trials;
+    using Clock = std::chrono::steady_clock;
+
+    // Descends from this node at position `state`
+    void select_leaf( Tree& tree,
+                      const State& state,
+                      RandomEngine& random,
+                      int virtual_loss,
+                      Leaf& leaf,
+                      MctsPhaseTimes* times );
+    static void evaluate( Leaf& leaf, RandomEngine& random, int playouts );
+    static void backpropagate( const Leaf& leaf, int virtual_loss );
+    // Moves the proof of the leaf up its path while it proves the parents
+    static void propagate_proof( const Leaf& leaf );
+    bool expand( Tree& tree, const State& state, RandomEngine& random, MctsPhaseTimes* times );
+    bool is_expanded( ) const;
+    // -1 when every child is proven
+    int select_child( bool& unexplored );
+    // Proves this node from the proofs of its children, where `my_turn` tells the side to move
+    Proof prove( bool my_turn );
+    // Node of the child at `index`, whose position is `state`. Null when the tree is full.
+    BasicMctsNode* get_child( Tree& tree, int index, const State& state );
+    std::atomic< int >* get_child_hits( ) const;
+    std::atomic< int >* get_child_trials( ) const;
+    std::atomic< int >* get_child_proofs( ) const;
+
+    static Proof get_proof( MctsState::Result result );
+
+private:
+    std::atomic< int > m_total_trials;
 
-    ChildrenPtr m_children;
+    std::atomic< Expansion > m_expansion;
+    std::atomic< Proof > m_proof;
+    std::atomic< int > m_explored_count;
+    int m_children_count;
+    // Edges are allocated next to each other in the tree's edge pool
+    Edge* m_children;
+    // Hits of all children followed by their trials and their proofs
+    std::atomic< int >* m_child_statistics;
 };
 
-}  // namespace mcts
\ No newline at end of file
+template < typename Game >
+BasicMctsNode< Game >::BasicMctsNode( )
+    : m_total_trials( 0 )
+    , m_expansion( Expansion::e_Expansion_None )
+    , m_proof( Proof::e_Proof_None )
+    , m_explored_count( 0 )
+    , m_children_count( 0 )
+    , m_children( nullptr )
+    , m_child_statistics( nullptr )
+{
+}
+
+template < typename Game >
+BasicMctsNode< Game >*
+BasicMctsNode< Game >::find_child( Move move ) const
+{
+    if ( is_expanded( ) )
+    {
+        for ( auto child = m_children; child != m_children + m_children_count; ++child )
+        {
+            if ( child->move == move )
+            {
+                return child->node.load( std::memory_order_acquire );
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+template < typename Game >
+void
+BasicMctsNode< Game >::visit_children(
+    std::function< void( Move, int, int, Proof ) > visitor ) const
+{
+    if ( is_expanded( ) )
+    {
+        auto const hits = get_child_hits( );
+        auto const trials = get_child_trials( );
+        auto const proofs = get_child_proofs( );
+        for ( int i = 0; i < m_children_count; ++i )
+        {
+            visitor( m_children[ i ].move, hits[ i ].load( std::memory_order_relaxed ),
+                     trials[ i ].load( std::memory_order_relaxed ),
+                     static_cast< Proof >( proofs[ i ].load( std::memory_order_relaxed ) ) );
+        }
+    }
+}
+
+template < typename Game >
+int
+BasicMctsNode< Game >::get_total_trials( ) const
+{
+    return m_total_trials.load( std::memory_order_relaxed );
+}
+
+template < typename Game >
+Proof
+BasicMctsNode< Game >::get_proof( ) const
+{
+    return m_proof.load( std::memory_order_relaxed );
+}
+
+template < typename Game >
+void
+BasicMctsNode< Game >::select_leaf( Tree& tree,
+                                    const State& state,
+                                    RandomEngine& random,
+                                    int virtual_loss,
+                                    Leaf& leaf,
+                                    MctsPhaseTimes* times )
+{
+    leaf.path.clear( );
+    leaf.state = state;
+    leaf.proof = Proof::e_Proof_None;
+
+    // A node that another thread is expanding is treated as a leaf, an unexplored child is
+    // simulated without expanding it. Selection stops at finished and proven positions.
+    auto node = this;
+    while ( node && node->expand( tree, leaf.state, random, times ) )
+    {
+        auto const my_turn = Game::is_my_turn( leaf.state );
+        if ( node->m_children_count == 0 )
+        {
+            leaf.proof = get_proof( Game::simulate( leaf.state, random ) );
+            node->m_proof.store( leaf.proof, std::memory_order_relaxed );
+            break;
+        }
+
+        bool unexplored = false;
+        auto const child = node->select_child( unexplored );
+        if ( child < 0 )
+        {
+            // Another thread proved the last child and is about to prove this node
+            leaf.proof = node->prove( my_turn );
+            break;
+        }
+
+        node->get_child_trials( )[ child ].fetch_add( virtual_loss, std::memory_order_relaxed );
+        leaf.path.push_back( {node, child, my_turn} );
+        Game::play( leaf.state, node->m_children[ child ].move );
+        node = node->get_child( tree, child, leaf.state );
+
+        // A transposed node may have been proven through another parent
+        auto const proof = node ? node->get_proof( ) : Proof::e_Proof_None;
+        if ( proof != Proof::e_Proof_None )
+        {
+            leaf.proof = proof;
+            break;
+        }
+        if ( unexplored )
+        {
+            break;
+        }
+    }
+    leaf.path.push_back( {node, -1, false} );
+}
+
+template < typename Game >
+void
+BasicMctsNode< Game >::evaluate( Leaf& leaf, RandomEngine& random, int playouts )
+{
+    leaf.hits = 0;
+    leaf.draws = 0;
+    leaf.trials = playouts;
+    if ( leaf.proof != Proof::e_Proof_None )
+    {
+        leaf.hits = leaf.proof == Proof::e_Proof_Hit ? playouts : 0;
+        leaf.draws = leaf.proof == Proof::e_Proof_Draw ? playouts : 0;
+        return;
+    }
+
+    for ( int i = 0; i < playouts; ++i )
+    {
+        switch ( Game::simulate( leaf.state, random ) )
+        {
+        case MctsState::Result::e_Result_Hit:
+            ++leaf.hits;
+            break;
+        case MctsState::Result::e_Result_Draw:
+            ++leaf.draws;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+template < typename Game >
+void
+BasicMctsNode< Game >::backpropagate( const Leaf& leaf, int virtual_loss )
+{
+    // Hits of both sides, also reverts the virtual loss of all edges on the path
+    auto const my_hits = 2 * leaf.hits + leaf.draws;
+    auto const opponent_hits = 2 * ( leaf.trials - leaf.hits - leaf.draws ) + leaf.draws;
+    for ( auto const& step : leaf.path )
+    {
+        if ( !step.node )
+        {
+            continue;
+        }
+
+        step.node->m_total_trials.fetch_add( leaf.trials, std::memory_order_relaxed );
+        if ( step.child >= 0 )
+        {
+            step.node->get_child_hits( )[ step.child ].fetch_add(
+                step.my_turn ? my_hits : opponent_hits, std::memory_order_relaxed );
+            step.node->get_child_trials( )[ step.child ].fetch_add(
+                leaf.trials - virtual_loss, std::memory_order_relaxed );
+        }
+    }
+
+    propagate_proof( leaf );
+}
+
+template < typename Game >
+void
+BasicMctsNode< Game >::propagate_proof( const Leaf& leaf )
+{
+    auto proof = leaf.proof;
+    for ( auto step = leaf.path.rbegin( ) + 1;
+          step != leaf.path.rend( ) && proof != Proof::e_Proof_None; ++step )
+    {
+        step->node->get_child_proofs( )[ step->child ].store( static_cast< int >( proof ),
+                                                              std::memory_order_relaxed );
+        proof = step->node->prove( step->my_turn );
+    }
+}
+
+template < typename Game >
+bool
+BasicMctsNode< Game >::expand( Tree& tree,
+                               const State& state,
+                               RandomEngine& random,
+                               MctsPhaseTimes* times )
+{
+    // A node of a full tree stays a leaf
+    auto expansion = m_expansion.load( std::memory_order_acquire );
+    if ( expansion == Expansion::e_Expansion_None && !tree.is_full( )
+         && m_expansion.compare_exchange_strong( expansion, Expansion::e_Expansion_InProgress,
+                                                 std::memory_order_acq_rel ) )
+    {
+        auto const start = times ? Clock::now( ) : Clock::time_point( );
+
+        typename Game::Moves moves;
+        Game::get_moves( state, moves );
+        // Unexplored children are picked in this order
+        std::shuffle( moves.begin( ), moves.end( ), random );
+        tree.create_children( *this, moves );
+
+        if ( times )
+        {
+            times->expansion += Clock::now( ) - start;
+        }
+        m_expansion.store( Expansion::e_Expansion_Done, std::memory_order_release );
+        return true;
+    }
+
+    return expansion == Expansion::e_Expansion_Done;
+}
+
+template < typename Game >
+bool
+BasicMctsNode< Game >::is_expanded( ) const
+{
+    return m_expansion.load( std::memory_order_acquire ) == Expansion::e_Expansion_Done;
+}
+
+template < typename Game >
+int
+BasicMctsNode< Game >::select_child( bool& unexplored )
+{
+    auto explored = m_explored_count.load( std::memory_order_relaxed );
+    while ( explored < m_children_count )
+    {
+        if ( m_explored_count.compare_exchange_weak( explored, explored + 1,
+                                                     std::memory_order_relaxed ) )
+        {
+            unexplored = true;
+            return explored;
+        }
+    }
+
+    // Other threads keep updating the counters, so the kernel scans a copy taken with relaxed
+    // loads. Slightly stale values are harmless. Reused by all selections of a thread.
+    static thread_local std::vector< int > statistics;
+    statistics.resize( 3 * m_children_count );
+    for ( int i = 0; i < 3 * m_children_count; ++i )
+    {
+        statistics[ i ] = m_child_statistics[ i ].load( std::memory_order_relaxed );
+    }
+
+    // Transposed nodes may have been visited through other parents before this node
+    auto const log_t = std::log( static_cast< float >( std::max( get_total_trials( ), 1 ) ) );
+    return select_ucb1( statistics.data( ), statistics.data( ) + m_children_count,
+                        statistics.data( ) + 2 * m_children_count, m_children_count, log_t,
+                        UCB1_EXPLORATION );
+}
+
+template < typename Game >
+Proof
+BasicMctsNode< Game >::prove( bool my_turn )
+{
+    auto const win = my_turn ? Proof::e_Proof_Hit : Proof::e_Proof_Miss;
+    auto const proofs = get_child_proofs( );
+    bool undecided = false;
+    bool draw = false;
+    for ( int i = 0; i < m_children_count; ++i )
+    {
+        auto const proof = static_cast< Proof >( proofs[ i ].load( std::memory_order_relaxed ) );
+        if ( proof == win )
+        {
+            m_proof.store( win, std::memory_order_relaxed );
+            return win;
+        }
+        undecided = undecided || proof == Proof::e_Proof_None;
+        draw = draw || proof == Proof::e_Proof_Draw;
+    }
+
+    if ( undecided )
+    {
+        return Proof::e_Proof_None;
+    }
+
+    auto const proof
+        = draw ? Proof::e_Proof_Draw : ( my_turn ? Proof::e_Proof_Miss : Proof::e_Proof_Hit );
+    m_proof.store( proof, std::memory_order_relaxed );
+    return proof;
+}
+
+template < typename Game >
+BasicMctsNode< Game >*
+BasicMctsNode< Game >::get_child( Tree& tree, int index, const State& state )
+{
+    auto const child = m_children[ index ].node.load( std::memory_order_acquire );
+    return child ? child : tree.create_child( *this, index, state );
+}
+
+template < typename Game >
+std::atomic< int >*
+BasicMctsNode< Game >::get_child_hits( ) const
+{
+    return m_child_statistics;
+}
+
+template < typename Game >
+std::atomic< int >*
+BasicMctsNode< Game >::get_child_trials( ) const
+{
+    return m_child_statistics + m_children_count;
+}
+
+template < typename Game >
+std::atomic< int >*
+BasicMctsNode< Game >::get_child_proofs( ) const
+{
+    return m_child_statistics + 2 * m_children_count;
+}
+
+template < typename Game >
+Proof
+BasicMctsNode< Game >::get_proof( MctsState::Result result )
+{
+    switch ( result )
+    {
+    case MctsState::Result::e_Result_Hit:
+        return Proof::e_Proof_Hit;
+    case MctsState::Result::e_Result_Miss:
+        return Proof::e_Proof_Miss;
+    case MctsState::Result::e_Result_Draw:
+        return Proof::e_Proof_Draw;
+    case MctsState::Result::e_Result_NotFinished:
+        break;
+    }
+    return Proof::e_Proof_None;
+}
+
+}  // namespace mcts
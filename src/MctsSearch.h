@@ -0,0 +1,661 @@
+#pragma once
+
+#include "Mcts.h"
+#include "OpeningBook.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mcts
+{
+enum class Parallelism
+{
+    // Every worker thread grows its own tree, root children statistics are merged
+    e_Parallelism_Root = 0,
+    // All worker threads share one tree, separated by virtual loss
+    e_Parallelism_Tree,
+};
+
+struct SearchSettings
+{
+    // Iterations per worker thread and move, each selects one leaf and runs playouts_per_leaf
+    // playouts from it
+    size_t iterations = 0;
+    size_t threads = 1;
+    Parallelism parallelism = Parallelism::e_Parallelism_Root;
+    // Only used by tree parallelization and batches
+    int virtual_loss = 3;
+    // Playouts run from every selected leaf
+    int playouts_per_leaf = 1;
+    // Playouts on the big board take small board wins, block those of the opponent and avoid
+    // giving the opponent a free choice of board, instead of playing random moves
+    bool tactical_playouts = false;
+    // Leaves selected by a worker before their playouts run and are back-propagated together.
+    // Leaves of one batch are separated by virtual loss, with any parallelization.
+    size_t batch_size = 1;
+    // When set, every move is searched for this long instead of a fixed number of iterations
+    std::chrono::milliseconds time_budget = std::chrono::milliseconds::zero( );
+    // Keep searching on a background thread while the opponent thinks, for at most the
+    // iterations or time budget of one move
+    bool ponder = false;
+    // Entries of the table sharing nodes between transpositions, zero disables it
+    size_t transposition_table_size = 1 << 16;
+    // Nodes per tree, zero is unlimited. A full tree stops expanding and keeps running playouts
+    // from its leaves. Every node also has an edge and three counters in its parent, the
+    // bytes_per_node counter of the benchmark tells the memory needed per node.
+    size_t max_nodes = 0;
+    // A full tree is instead pruned to half of max_nodes by collapsing its least visited
+    // subtrees, and the search goes on expanding
+    bool recycle_nodes = false;
+    // Seeds the random generators of all workers, a single thread with a fixed number of
+    // iterations plays the same moves for the same seed
+    uint64_t seed = 0;
+    // Collects depths, phase times and root statistics of every search, which slows it down
+    bool collect_statistics = false;
+    // Positions found in the book are answered without searching, with the move that the search
+    // would choose from the statistics of the book
+    std::shared_ptr< const OpeningBook > opening_book;
+};
+
+// What the last search did. Iterations, times and tree sizes are always filled, the rest only
+// when SearchSettings::collect_statistics is set. A position answered by the opening book has
+// no iterations and the root children of the book.
+struct SearchStatistics
+{
+    struct ChildStatistics
+    {
+        Move move;
+        // Two per won playout and one per draw for the side to move in the searched position
+        long long hits;
+        long long total_trials;
+        Proof proof;
+    };
+
+    double
+    get_playouts_per_second( ) const
+    {
+        return wall_time.count( ) > 0 ? playouts * 1e9 / wall_time.count( ) : 0.0;
+    }
+
+    size_t iterations = 0;
+    size_t playouts = 0;
+    std::chrono::nanoseconds wall_time{0};
+    // Of all trees once the search finished
+    size_t node_count = 0;
+    // Bytes of the nodes, edges, statistics and transposition tables
+    size_t memory_usage = 0;
+
+    // Depth of the selected leaves
+    int max_depth = 0;
+    double average_depth = 0.0;
+    // Most visited line from the searched position in the first tree
+    std::vector< Move > principal_variation;
+    // Moves from the searched position, merged over all trees
+    std::vector< ChildStatistics > root_children;
+    // Summed over all workers
+    MctsPhaseTimes phase_times;
+    // The move was taken from the opening book without searching
+    bool from_book = false;
+    // The value of the searched position is proven in every tree, searching it again returns
+    // at once
+    bool solved = false;
+};
+
+// Game independent handle of the search trees of one game, so callers can choose the game at
+// run time while the search itself is compiled for every game
+struct MctsSearch
+{
+    using Clock = std::chrono::steady_clock;
+
+    virtual ~MctsSearch( )
+    {
+    }
+
+    // Runs every worker until it completed `iterations` iterations, `deadline` passed or
+    // `stop` is set. Returns the number of iterations completed by all workers.
+    virtual size_t search( size_t iterations,
+                           Clock::time_point deadline,
+                           const std::atomic< bool >& stop )
+        = 0;
+    // Proven win of the current position, otherwise its most visited move that is not a proven
+    // loss, -1 when the game is finished
+    virtual Move get_best_move( ) const = 0;
+    // Makes the position after `move` the current one
+    virtual void play_move( Move move ) = 0;
+    // True when the current position has no moves
+    virtual bool is_finished( ) const = 0;
+    // True when `move` can be played in the current position
+    virtual bool is_legal( Move move ) const = 0;
+    virtual const SearchStatistics& get_statistics( ) const = 0;
+    // Writes the current position and every tree to a TreeSnapshot file, false when it cannot
+    // be written. Must not run concurrently with a search.
+    virtual bool save_snapshot( const std::string& path ) const = 0;
+    // Continues from the position and trees of a snapshot of the same game, false when the file
+    // does not hold one. Tree i resumes from tree i modulo the trees of the snapshot.
+    virtual bool load_snapshot( const std::string& path ) = 0;
+};
+
+template < typename Game >
+struct GameSearch : public MctsSearch
+{
+    GameSearch( const typename Game::State& state, const SearchSettings& settings );
+
+    size_t search( size_t iterations,
+                   Clock::time_point deadline,
+                   const std::atomic< bool >& stop ) override;
+    Move get_best_move( ) const override;
+    void play_move( Move move ) override;
+    bool is_finished( ) const override;
+    bool is_legal( Move move ) const override;
+    const SearchStatistics& get_statistics( ) const override;
+    bool save_snapshot( const std::string& path ) const override;
+    bool load_snapshot( const std::string& path ) override;
+
+private:
+    using Tree = Mcts< Game >;
+
+    struct WorkerLimits
+    {
+        size_t iterations;
+        Clock::time_point deadline;
+        const std::atomic< bool >* stop;
+        size_t batch_size;
+        int virtual_loss;
+        int playouts;
+        // Workers return once their tree is full, so it can be recycled
+        bool stop_when_full;
+    };
+
+    using ChildStatistics = SearchStatistics::ChildStatistics;
+
+    struct WorkerResult
+    {
+        size_t iterations = 0;
+        size_t depth_sum = 0;
+        int max_depth = 0;
+        MctsPhaseTimes phase_times;
+    };
+
+    void run_workers( const WorkerLimits& limits, std::vector< WorkerResult >& results );
+    // Compiled with and without statistics, so a search without them pays nothing
+    template < bool COLLECT >
+    static void run_worker( Tree& tree,
+                            RandomEngine& random,
+                            const WorkerLimits& limits,
+                            WorkerResult& result );
+    // Recycles every full tree, false when no tree was full or one is still full afterwards
+    bool recycle_full_trees( );
+    bool is_solved( ) const;
+    // Takes the move of the current position from the opening book, false when it is not there
+    bool answer_from_book( );
+    // Move among `children` of the current position that is played
+    Move choose_move( const std::vector< ChildStatistics >& children ) const;
+    std::vector< ChildStatistics > merge_root_children( ) const;
+    std::vector< Move > get_principal_variation( ) const;
+    void update_statistics( const std::vector< WorkerResult >& results,
+                            std::chrono::nanoseconds wall_time );
+
+private:
+    const SearchSettings m_settings;
+    // Every tree is rooted at the current position
+    std::vector< std::unique_ptr< Tree > > m_trees;
+    std::vector< RandomEngine > m_randoms;
+    SearchStatistics m_statistics;
+    // Move of the current position from the opening book, -1 when it was searched
+    Move m_book_move;
+};
+
+namespace detail
+{
+// The clock is only read once per this many iterations of a worker
+size_t const CLOCK_CHECK_INTERVAL = 32;
+
+}  // namespace detail
+
+template < typename Game >
+GameSearch< Game >::GameSearch( const typename Game::State& state,
+                                const SearchSettings& settings )
+    : m_settings( settings )
+    , m_trees( settings.parallelism == Parallelism::e_Parallelism_Tree
+                   ? 1
+                   : std::max< size_t >( settings.threads, 1 ) )
+    , m_randoms( std::max< size_t >( settings.threads, 1 ) )
+    , m_book_move( -1 )
+{
+    for ( auto& tree : m_trees )
+    {
+        tree.reset(
+            new Mcts< Game >( state, settings.transposition_table_size, settings.max_nodes ) );
+    }
+
+    // Every worker continues where the stream of the previous one was jumped to
+    RandomEngine random( settings.seed );
+    for ( auto& worker_random : m_randoms )
+    {
+        worker_random = random;
+        random.jump( );
+    }
+}
+
+template < typename Game >
+size_t
+GameSearch< Game >::search( size_t iterations,
+                            Clock::time_point deadline,
+                            const std::atomic< bool >& stop )
+{
+    if ( m_book_move >= 0 || ( m_settings.opening_book && answer_from_book( ) ) )
+    {
+        return 0;
+    }
+
+    auto const batch_size = std::max< size_t >( m_settings.batch_size, 1 );
+    WorkerLimits limits{
+        iterations,
+        deadline,
+        &stop,
+        batch_size,
+        m_settings.parallelism == Parallelism::e_Parallelism_Tree || batch_size > 1
+            ? m_settings.virtual_loss
+            : 0,
+        std::max( m_settings.playouts_per_leaf, 1 ),
+        m_settings.max_nodes > 0 && m_settings.recycle_nodes};
+
+    // Workers continue after every recycling round. When recycling cannot make room they run
+    // once more with a full tree. A solved position is not searched at all.
+    auto const start = Clock::now( );
+    std::vector< WorkerResult > results( m_randoms.size( ) );
+    while ( !is_solved( ) )
+    {
+        run_workers( limits, results );
+        if ( !limits.stop_when_full || stop.load( std::memory_order_relaxed )
+             || Clock::now( ) >= deadline )
+        {
+            break;
+        }
+
+        limits.stop_when_full = recycle_full_trees( );
+        auto const finished = std::all_of(
+            results.begin( ), results.end( ), [&limits]( const WorkerResult& result ) {
+                return result.iterations >= limits.iterations;
+            } );
+        if ( finished )
+        {
+            break;
+        }
+    }
+
+    update_statistics( results, Clock::now( ) - start );
+    return m_statistics.iterations;
+}
+
+template < typename Game >
+Move
+GameSearch< Game >::get_best_move( ) const
+{
+    if ( m_book_move >= 0 )
+    {
+        return m_book_move;
+    }
+
+    // A position that was not searched still gets a legal move
+    auto const merged = merge_root_children( );
+    if ( merged.empty( ) )
+    {
+        typename Game::Moves moves;
+        Game::get_moves( m_trees.front( )->get_state( ), moves );
+        return moves.size( ) > 0 ? moves[ 0 ] : -1;
+    }
+
+    return choose_move( merged );
+}
+
+template < typename Game >
+void
+GameSearch< Game >::play_move( Move move )
+{
+    m_book_move = -1;
+    for ( auto& tree : m_trees )
+    {
+        tree->reroot( move );
+    }
+}
+
+template < typename Game >
+bool
+GameSearch< Game >::is_finished( ) const
+{
+    typename Game::Moves moves;
+    Game::get_moves( m_trees.front( )->get_state( ), moves );
+    return moves.size( ) == 0;
+}
+
+template < typename Game >
+bool
+GameSearch< Game >::is_legal( Move move ) const
+{
+    typename Game::Moves moves;
+    Game::get_moves( m_trees.front( )->get_state( ), moves );
+    return std::find( moves.begin( ), moves.end( ), move ) != moves.end( );
+}
+
+template < typename Game >
+const SearchStatistics&
+GameSearch< Game >::get_statistics( ) const
+{
+    return m_statistics;
+}
+
+template < typename Game >
+bool
+GameSearch< Game >::save_snapshot( const std::string& path ) const
+{
+    std::vector< TreeSnapshot::Tree > snapshots( m_trees.size( ) );
+    for ( size_t i = 0; i < m_trees.size( ); ++i )
+    {
+        m_trees[ i ]->save( snapshots[ i ] );
+    }
+    return TreeSnapshot::write( path, Game::BOARD_SIZE, snapshots );
+}
+
+template < typename Game >
+bool
+GameSearch< Game >::load_snapshot( const std::string& path )
+{
+    TreeSnapshot snapshot;
+    if ( !snapshot.open( path, Game::BOARD_SIZE, sizeof( typename Game::State ) ) )
+    {
+        return false;
+    }
+
+    for ( size_t i = 0; i < snapshot.get_tree_count( ); ++i )
+    {
+        typename Game::State state;
+        std::memcpy( &state, snapshot.get_tree( i ).state, sizeof( state ) );
+        if ( !Game::is_valid( state ) )
+        {
+            return false;
+        }
+    }
+
+    m_book_move = -1;
+    for ( size_t i = 0; i < m_trees.size( ); ++i )
+    {
+        m_trees[ i ]->restore( snapshot.get_tree( i % snapshot.get_tree_count( ) ) );
+    }
+    return true;
+}
+
+template < typename Game >
+void
+GameSearch< Game >::run_workers( const WorkerLimits& limits, std::vector< WorkerResult >& results )
+{
+    auto const run = m_settings.collect_statistics ? &GameSearch::run_worker< true >
+                                                   : &GameSearch::run_worker< false >;
+    if ( m_randoms.size( ) == 1 )
+    {
+        run( *m_trees.front( ), m_randoms.front( ), limits, results.front( ) );
+        return;
+    }
+
+    std::vector< std::thread > threads;
+    threads.reserve( m_randoms.size( ) );
+    for ( size_t i = 0; i < m_randoms.size( ); ++i )
+    {
+        threads.emplace_back( run, std::ref( *m_trees[ i % m_trees.size( ) ] ),
+                              std::ref( m_randoms[ i ] ), std::cref( limits ),
+                              std::ref( results[ i ] ) );
+    }
+    for ( auto& thread : threads )
+    {
+        thread.join( );
+    }
+}
+
+// Every worker runs until its iterations or the time are used up, or the search is stopped.
+// At least one iteration is needed to expand the current node. A worker continues with the
+// iterations of its result, which accumulates over recycling rounds.
+template < typename Game >
+template < bool COLLECT >
+void
+GameSearch< Game >::run_worker( Tree& tree,
+                                RandomEngine& random,
+                                const WorkerLimits& limits,
+                                WorkerResult& result )
+{
+    auto const check_clock = limits.deadline != Clock::time_point::max( );
+    auto const times = COLLECT ? &result.phase_times : nullptr;
+
+    size_t cnt = result.iterations;
+    if ( ( cnt > 0 && cnt >= limits.iterations ) || tree.is_solved( ) )
+    {
+        return;
+    }
+
+    typename Tree::Node::Leaves leaves;
+    size_t next_clock_check = cnt + detail::CLOCK_CHECK_INTERVAL;
+    do
+    {
+        auto const batch = std::min( limits.batch_size, limits.iterations - cnt );
+        if ( batch > 1 )
+        {
+            leaves.resize( batch );
+            tree.choose_children( random, leaves, limits.virtual_loss, limits.playouts, times );
+            if ( COLLECT )
+            {
+                for ( auto const& leaf : leaves )
+                {
+                    auto const depth = static_cast< int >( leaf.path.size( ) ) - 1;
+                    result.depth_sum += depth;
+                    result.max_depth = std::max( result.max_depth, depth );
+                }
+            }
+        }
+        else
+        {
+            auto const depth
+                = tree.choose_child( random, limits.virtual_loss, limits.playouts, times );
+            if ( COLLECT )
+            {
+                result.depth_sum += depth;
+                result.max_depth = std::max( result.max_depth, depth );
+            }
+        }
+        cnt += batch;
+
+        if ( check_clock && cnt >= next_clock_check )
+        {
+            if ( Clock::now( ) >= limits.deadline )
+            {
+                break;
+            }
+            next_clock_check = cnt + detail::CLOCK_CHECK_INTERVAL;
+        }
+    } while ( cnt < limits.iterations && !limits.stop->load( std::memory_order_relaxed )
+              && !( limits.stop_when_full && tree.is_full( ) ) && !tree.is_solved( ) );
+    result.iterations = cnt;
+}
+
+template < typename Game >
+bool
+GameSearch< Game >::recycle_full_trees( )
+{
+    bool recycled = false;
+    for ( auto& tree : m_trees )
+    {
+        if ( tree->is_full( ) )
+        {
+            tree->recycle( m_settings.max_nodes / 2 );
+            if ( tree->is_full( ) )
+            {
+                return false;
+            }
+            recycled = true;
+        }
+    }
+    return recycled;
+}
+
+template < typename Game >
+bool
+GameSearch< Game >::is_solved( ) const
+{
+    return std::all_of( m_trees.begin( ), m_trees.end( ),
+                        []( const std::unique_ptr< Tree >& tree ) { return tree->is_solved( ); } );
+}
+
+template < typename Game >
+bool
+GameSearch< Game >::answer_from_book( )
+{
+    auto const records
+        = m_settings.opening_book->find( Game::get_hash( m_trees.front( )->get_state( ) ) );
+    if ( records.first == records.second )
+    {
+        return false;
+    }
+
+    m_statistics = SearchStatistics( );
+    m_statistics.from_book = true;
+    for ( auto record = records.first; record != records.second; ++record )
+    {
+        m_statistics.root_children.push_back(
+            {record->move, record->hits, record->trials, static_cast< Proof >( record->proof )} );
+    }
+    m_book_move = choose_move( m_statistics.root_children );
+    return true;
+}
+
+template < typename Game >
+Move
+GameSearch< Game >::choose_move( const std::vector< ChildStatistics >& children ) const
+{
+    // A proven win beats everything and a proven loss is only played when every move loses.
+    // Among the others the most visited child is the most robust choice.
+    auto const my_turn = Game::is_my_turn( m_trees.front( )->get_state( ) );
+    auto const get_rank = [my_turn]( const ChildStatistics& child ) {
+        if ( child.proof == ( my_turn ? Proof::e_Proof_Hit : Proof::e_Proof_Miss ) )
+        {
+            return 2;
+        }
+        return child.proof == ( my_turn ? Proof::e_Proof_Miss : Proof::e_Proof_Hit ) ? 0 : 1;
+    };
+    auto const best = std::max_element(
+        children.begin( ), children.end( ),
+        [&get_rank]( const ChildStatistics& lhs, const ChildStatistics& rhs ) {
+            auto const lhs_rank = get_rank( lhs );
+            auto const rhs_rank = get_rank( rhs );
+            return lhs_rank < rhs_rank
+                   || ( lhs_rank == rhs_rank
+                        && ( lhs.total_trials < rhs.total_trials
+                             || ( lhs.total_trials == rhs.total_trials
+                                  && lhs.hits < rhs.hits ) ) );
+        } );
+    return best->move;
+}
+
+template < typename Game >
+std::vector< typename GameSearch< Game >::ChildStatistics >
+GameSearch< Game >::merge_root_children( ) const
+{
+    // A proof of any tree holds for all of them
+    std::vector< ChildStatistics > merged;
+    for ( auto const& tree : m_trees )
+    {
+        tree->get_root( )->visit_children(
+            [&merged]( Move move, int hits, int total_trials, Proof proof ) {
+                auto it = std::find_if(
+                    merged.begin( ), merged.end( ),
+                    [move]( const ChildStatistics& child ) { return child.move == move; } );
+                if ( it == merged.end( ) )
+                {
+                    it = merged.insert( merged.end( ),
+                                        ChildStatistics{move, 0, 0, Proof::e_Proof_None} );
+                }
+                it->hits += hits;
+                it->total_trials += total_trials;
+                if ( proof != Proof::e_Proof_None )
+                {
+                    it->proof = proof;
+                }
+            } );
+    }
+    return merged;
+}
+
+template < typename Game >
+std::vector< Move >
+GameSearch< Game >::get_principal_variation( ) const
+{
+    std::vector< Move > variation;
+    for ( auto node = m_trees.front( )->get_root( ); node; )
+    {
+        Move best = -1;
+        int best_trials = 0;
+        node->visit_children( [&best, &best_trials]( Move move, int, int total_trials, Proof ) {
+            if ( total_trials > best_trials )
+            {
+                best = move;
+                best_trials = total_trials;
+            }
+        } );
+        if ( best < 0 )
+        {
+            break;
+        }
+
+        variation.push_back( best );
+        node = node->find_child( best );
+    }
+    return variation;
+}
+
+template < typename Game >
+void
+GameSearch< Game >::update_statistics( const std::vector< WorkerResult >& results,
+                                       std::chrono::nanoseconds wall_time )
+{
+    m_statistics = SearchStatistics( );
+    m_statistics.wall_time = wall_time;
+    m_statistics.solved = is_solved( );
+
+    size_t depth_sum = 0;
+    for ( auto const& result : results )
+    {
+        m_statistics.iterations += result.iterations;
+        depth_sum += result.depth_sum;
+        m_statistics.max_depth = std::max( m_statistics.max_depth, result.max_depth );
+        m_statistics.phase_times.selection += result.phase_times.selection;
+        m_statistics.phase_times.expansion += result.phase_times.expansion;
+        m_statistics.phase_times.simulation += result.phase_times.simulation;
+        m_statistics.phase_times.backpropagation += result.phase_times.backpropagation;
+    }
+    m_statistics.playouts = m_statistics.iterations
+                            * static_cast< size_t >( std::max( m_settings.playouts_per_leaf, 1 ) );
+
+    for ( auto const& tree : m_trees )
+    {
+        m_statistics.node_count += tree->get_node_count( );
+        m_statistics.memory_usage
+            += tree->get_memory_usage( ) + tree->get_transposition_memory_usage( );
+    }
+
+    if ( m_settings.collect_statistics )
+    {
+        m_statistics.average_depth
+            = m_statistics.iterations > 0
+                  ? static_cast< double >( depth_sum ) / m_statistics.iterations
+                  : 0.0;
+        m_statistics.principal_variation = get_principal_variation( );
+        m_statistics.root_children = merge_root_children( );
+    }
+}
+
+}  // namespace mcts
@@ -1,14 +1,20 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
+#include "Random.h"
+
 namespace mcts
 {
-struct MctsNode;
-using MctsNodePtr = std::shared_ptr< MctsNode >;
-using Children = std::vector< MctsNodePtr >;
-using ChildrenPtr = std::unique_ptr< Children >;
+struct MctsState;
+using States = std::vector< std::unique_ptr< MctsState > >;
+// Every search thread owns one engine
+using RandomEngine = Xoshiro256;
+// Game specific move encoding
+using Move = int;
+using Hash = uint64_t;
 
 struct MctsState
 {
@@ -24,8 +30,28 @@ struct MctsState
     {
     }
 
-    virtual Result simulate( ) const = 0;
-    virtual ChildrenPtr get_children( MctsNodePtr parent ) const = 0;
+    virtual Result simulate( RandomEngine& random ) const = 0;
+    // True when the side the search started for is to move
+    virtual bool is_my_turn( ) const = 0;
+    virtual States get_children( ) const = 0;
+    // State after `move`, null when it is not legal here. Looks the move up among all children
+    // unless overridden.
+    virtual std::unique_ptr< MctsState >
+    play( Move move ) const
+    {
+        for ( auto& child : get_children( ) )
+        {
+            if ( child->get_move( ) == move )
+            {
+                return std::move( child );
+            }
+        }
+        return nullptr;
+    }
+    // Move that led to this state
+    virtual Move get_move( ) const = 0;
+    // Equal for the same position reached by different move orders
+    virtual Hash get_hash( ) const = 0;
 };
 
 }  // namespace mcts
\ No newline at end of file
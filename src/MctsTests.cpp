@@ -0,0 +1,552 @@
+#include "GameState.h"
+#include "MatchServer.h"
+#include "MctsSearch.h"
+#include "MctsTree.h"
+#include "OpeningBook.h"
+#include "TicTacToeBigGame.h"
+#include "TicTacToeGame.h"
+#include "TicTacToeGameAi.h"
+#include "TreeSnapshot.h"
+#include "UcbSelection.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Regression tests of the search, run by ctest. Every check reports its failure and the test
+// exits with a nonzero status when any check failed.
+
+namespace
+{
+using namespace mcts;
+
+int failures = 0;
+
+#define CHECK( condition )                                                                   \
+    do                                                                                       \
+    {                                                                                        \
+        if ( !( condition ) )                                                                \
+        {                                                                                    \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition        \
+                      << std::endl;                                                          \
+            ++failures;                                                                      \
+        }                                                                                    \
+    } while ( false )
+
+template < typename Game >
+bool
+is_legal( const typename Game::State& state, Move move )
+{
+    typename Game::Moves moves;
+    Game::get_moves( state, moves );
+    return std::find( moves.begin( ), moves.end( ), move ) != moves.end( );
+}
+
+template < typename Game >
+bool
+is_finished( const typename Game::State& state )
+{
+    typename Game::Moves moves;
+    Game::get_moves( state, moves );
+    return moves.size( ) == 0;
+}
+
+// Collapsed subtrees must not keep the proofs of their children, every move of a small
+// recycled tree stays legal
+template < typename Game >
+void
+test_recycling_keeps_moves_legal( const typename Game::State& start, uint64_t seed )
+{
+    SearchSettings settings;
+    settings.iterations = 3000;
+    settings.max_nodes = 300;
+    settings.recycle_nodes = true;
+    settings.seed = seed;
+    settings.collect_statistics = true;
+    GameSearch< Game > search( start, settings );
+
+    auto state = start;
+    RandomEngine random( seed );
+    std::atomic< bool > const stop( false );
+    for ( auto my_turn = true; !is_finished< Game >( state ); my_turn = !my_turn )
+    {
+        Move move;
+        if ( my_turn )
+        {
+            // The move comes from the statistics of the root, not from a proof without them
+            search.search( settings.iterations, MctsSearch::Clock::time_point::max( ), stop );
+            CHECK( !search.get_statistics( ).root_children.empty( ) );
+            move = search.get_best_move( );
+            CHECK( is_legal< Game >( state, move ) );
+            if ( !is_legal< Game >( state, move ) )
+            {
+                return;
+            }
+        }
+        else
+        {
+            typename Game::Moves moves;
+            Game::get_moves( state, moves );
+            move = moves[ bounded( random, moves.size( ) ) ];
+        }
+        Game::play( state, move );
+        search.play_move( move );
+    }
+}
+
+// A proven win is played even when another move of the book has more trials
+void
+test_book_plays_proven_wins( )
+{
+    // Cells 2 and 4 against 1 and 7, cell 6 wins at once
+    auto const state = TicTacToeGame::make_state(
+        bitboard::cell_mask( 2 ) | bitboard::cell_mask( 4 ),
+        bitboard::cell_mask( 1 ) | bitboard::cell_mask( 7 ), true );
+    auto const hash = TicTacToeGame::get_hash( state );
+    std::vector< OpeningBook::Record > const records{
+        {hash, 5, 12, 10, static_cast< int32_t >( Proof::e_Proof_None )},
+        {hash, 6, 8, 4, static_cast< int32_t >( Proof::e_Proof_Hit )},
+        {hash, 8, 0, 2, static_cast< int32_t >( Proof::e_Proof_Miss )}};
+
+    std::string const path = "mcts_tests_book.bin";
+    CHECK( OpeningBook::write( path, TicTacToeGame::BOARD_SIZE, records ) );
+    auto const book = std::make_shared< OpeningBook >( );
+    CHECK( book->open( path, TicTacToeGame::BOARD_SIZE ) );
+
+    SearchSettings settings;
+    settings.iterations = 1;
+    settings.opening_book = book;
+    GameSearch< TicTacToeGame > search( state, settings );
+    std::atomic< bool > const stop( false );
+    search.search( settings.iterations, MctsSearch::Clock::time_point::max( ), stop );
+    CHECK( search.get_statistics( ).from_book );
+    CHECK( search.get_best_move( ) == 6 );
+
+    // A book of the other board size is rejected
+    OpeningBook other;
+    CHECK( !other.open( path, TicTacToeBigGame::BOARD_SIZE ) );
+    std::remove( path.c_str( ) );
+}
+
+std::vector< char >
+read_file( const std::string& path )
+{
+    std::ifstream file( path, std::ios::binary );
+    return std::vector< char >( std::istreambuf_iterator< char >( file ),
+                                std::istreambuf_iterator< char >( ) );
+}
+
+// A restored snapshot continues with the same trees, so saving it again gives the same bytes
+void
+test_snapshot_round_trip( )
+{
+    SearchSettings settings;
+    settings.iterations = 5000;
+    settings.threads = 2;
+    settings.collect_statistics = true;
+    auto const start = TicTacToeBigGame::make_state( TicTacToeBigGame::Boards{},
+                                                     TicTacToeBigGame::Boards{}, true );
+    GameSearch< TicTacToeBigGame > source( start, settings );
+    std::atomic< bool > const stop( false );
+    source.search( settings.iterations, MctsSearch::Clock::time_point::max( ), stop );
+
+    std::string const path = "mcts_tests_snapshot.bin";
+    std::string const copy_path = "mcts_tests_snapshot_copy.bin";
+    CHECK( source.save_snapshot( path ) );
+
+    GameSearch< TicTacToeBigGame > restored( start, settings );
+    CHECK( restored.load_snapshot( path ) );
+    CHECK( restored.get_best_move( ) == source.get_best_move( ) );
+    CHECK( restored.save_snapshot( copy_path ) );
+    auto const saved = read_file( path );
+    CHECK( !saved.empty( ) && saved == read_file( copy_path ) );
+
+    // A snapshot of the other board size is rejected
+    GameSearch< TicTacToeGame > other( TicTacToeGame::make_state( 0, 0, true ), settings );
+    CHECK( !other.load_snapshot( path ) );
+
+    // So is a snapshot with a corrupted position or tree. The position of the first tree follows
+    // the header of the file and the node and edge counts of the tree, its edges follow its nodes.
+    using State = TicTacToeBigGame::State;
+    size_t const state_offset = 24 + 16;
+    uint64_t node_count = 0;
+    std::memcpy( &node_count, saved.data( ) + 24, sizeof( node_count ) );
+    size_t const edge_offset = state_offset + ( sizeof( State ) + 7 ) / 8 * 8
+                               + node_count * sizeof( TreeSnapshot::Node );
+    auto const loads_corrupted = [&]( size_t offset, int32_t value, size_t size ) {
+        auto corrupted = saved;
+        std::memcpy( corrupted.data( ) + offset, &value, size );
+        std::ofstream( copy_path, std::ios::binary )
+            .write( corrupted.data( ), static_cast< std::streamsize >( corrupted.size( ) ) );
+        GameSearch< TicTacToeBigGame > search( start, settings );
+        return search.load_snapshot( copy_path );
+    };
+    CHECK( !loads_corrupted( state_offset + offsetof( State, my_turn ), 2, 1 ) );
+    CHECK( !loads_corrupted( state_offset + offsetof( State, target_board ), 9, 4 ) );
+    CHECK( !loads_corrupted( state_offset + offsetof( State, result ), 7, 4 ) );
+    CHECK( !loads_corrupted( state_offset + offsetof( State, won_mine ), 1, 1 ) );
+    CHECK( !loads_corrupted( edge_offset + offsetof( TreeSnapshot::Edge, move ), 81, 4 ) );
+    // The first child of the root leads back to the root
+    CHECK( !loads_corrupted( edge_offset + offsetof( TreeSnapshot::Edge, node ), 0, 4 ) );
+
+    std::remove( path.c_str( ) );
+    std::remove( copy_path.c_str( ) );
+}
+
+// Longest a server reply may take, far above the time any of these searches needs
+const std::chrono::seconds REPLY_TIMEOUT( 30 );
+
+// Waits for the reply of the server and checks that it is legal in `state`, -1 when the game is
+// finished
+Move
+get_reply( std::future< MovePosition > reply, const TicTacToeGame::State& state )
+{
+    if ( reply.wait_for( REPLY_TIMEOUT ) != std::future_status::ready )
+    {
+        CHECK( !"the server did not reply" );
+        return -1;
+    }
+
+    auto const position = reply.get( );
+    if ( is_finished< TicTacToeGame >( state ) )
+    {
+        CHECK( position.row < 0 && position.col < 0 );
+        return -1;
+    }
+
+    auto const move = position.row * TicTacToeGame::BOARD_SIZE + position.col;
+    CHECK( is_legal< TicTacToeGame >( state, move ) );
+    return move;
+}
+
+// A solved position or a finished game get no more iterations, the server must reply anyway
+void
+test_server_replies_in_solved_positions( bool timed )
+{
+    MatchSettings settings;
+    settings.threads = 2;
+    if ( timed )
+    {
+        settings.search.time_budget = std::chrono::duration_cast< std::chrono::milliseconds >(
+            REPLY_TIMEOUT * 10 );
+    }
+    else
+    {
+        settings.search.iterations = 200000;
+    }
+    MatchServer server( settings );
+
+    auto const game = server.create_game( MatchServer::AvailableCells(
+        TicTacToeGame::BOARD_SIZE, std::vector< bool >( TicTacToeGame::BOARD_SIZE, true ) ) );
+    auto state = TicTacToeGame::make_state( 0, 0, true );
+    RandomEngine random( 1 );
+    for ( auto move = get_reply( server.get_my_move( game ), state ); move >= 0; )
+    {
+        TicTacToeGame::play( state, move );
+        if ( is_finished< TicTacToeGame >( state ) )
+        {
+            break;
+        }
+
+        TicTacToeGame::Moves moves;
+        TicTacToeGame::get_moves( state, moves );
+        auto const reply = moves[ bounded( random, moves.size( ) ) ];
+        TicTacToeGame::play( state, reply );
+        move = get_reply( server.opponent_move( game, {reply / TicTacToeGame::BOARD_SIZE,
+                                                       reply % TicTacToeGame::BOARD_SIZE} ),
+                          state );
+    }
+}
+
+// The kernel, vectorized where AVX2 is available, picks a child of the highest UCB1 value among
+// those not skipped. Counts up to 40 cover full vectors and the scalar tail.
+void
+test_ucb1_selection( )
+{
+    RandomEngine random( 11 );
+    for ( int round = 0; round < 2000; ++round )
+    {
+        auto const count = 1 + static_cast< int >( bounded( random, 40 ) );
+        std::vector< int > hits( count ), trials( count ), skipped( count );
+        for ( int i = 0; i < count; ++i )
+        {
+            trials[ i ] = static_cast< int >( bounded( random, 50 ) );
+            hits[ i ] = static_cast< int >( bounded( random, 2 * trials[ i ] + 1 ) );
+            skipped[ i ] = bounded( random, 4 ) == 0;
+        }
+        auto const log_t = std::log( static_cast< float >( 1 + bounded( random, 2000 ) ) );
+
+        auto best_value = std::numeric_limits< float >::lowest( );
+        for ( int i = 0; i < count; ++i )
+        {
+            auto const n = static_cast< float >( std::max( trials[ i ], 1 ) );
+            auto const value = 0.5f * hits[ i ] / n + UCB1_EXPLORATION * std::sqrt( log_t / n );
+            best_value = skipped[ i ] ? best_value : std::max( best_value, value );
+        }
+
+        auto const best = select_ucb1( hits.data( ), trials.data( ), skipped.data( ), count, log_t,
+                                       UCB1_EXPLORATION );
+        if ( std::all_of( skipped.begin( ), skipped.end( ), []( int skip ) { return skip != 0; } ) )
+        {
+            CHECK( best == -1 );
+            continue;
+        }
+
+        CHECK( best >= 0 && best < count && !skipped[ best ] );
+        if ( best >= 0 && best < count )
+        {
+            auto const n = static_cast< float >( std::max( trials[ best ], 1 ) );
+            auto const value
+                = 0.5f * hits[ best ] / n + UCB1_EXPLORATION * std::sqrt( log_t / n );
+            CHECK( std::fabs( value - best_value ) <= 1e-5f * best_value );
+        }
+    }
+}
+
+// Results, hashes and forced boards updated by every move must equal those of make_state( ),
+// which scans every line of the position
+void
+test_incremental_results( )
+{
+    RandomEngine random( 19 );
+    for ( int game = 0; game < 20000; ++game )
+    {
+        auto small = TicTacToeGame::make_state( 0, 0, true );
+        while ( true )
+        {
+            TicTacToeGame::Moves moves;
+            TicTacToeGame::get_moves( small, moves );
+            if ( moves.size( ) == 0 )
+            {
+                break;
+            }
+
+            TicTacToeGame::play( small, moves[ bounded( random, moves.size( ) ) ] );
+            auto const scanned
+                = TicTacToeGame::make_state( small.mine, small.opponent, small.my_turn );
+            CHECK( small.result == scanned.result && small.hash == scanned.hash );
+        }
+
+        auto big = TicTacToeBigGame::make_state( TicTacToeBigGame::Boards{},
+                                                 TicTacToeBigGame::Boards{}, true );
+        while ( true )
+        {
+            TicTacToeBigGame::Moves moves;
+            TicTacToeBigGame::get_moves( big, moves );
+            if ( moves.size( ) == 0 )
+            {
+                break;
+            }
+
+            auto const move = moves[ bounded( random, moves.size( ) ) ];
+            TicTacToeBigGame::play( big, move );
+            auto const scanned
+                = TicTacToeBigGame::make_state( big.mine, big.opponent, big.my_turn, move );
+            CHECK( big.result == scanned.result && big.won_mine == scanned.won_mine
+                   && big.won_opponent == scanned.won_opponent && big.drawn == scanned.drawn
+                   && big.target_board == scanned.target_board && big.hash == scanned.hash );
+        }
+    }
+}
+
+// True when `request` throws std::invalid_argument
+template < typename Request >
+bool
+is_rejected( Request request )
+{
+    try
+    {
+        request( );
+    }
+    catch ( const std::invalid_argument& )
+    {
+        return true;
+    }
+    return false;
+}
+
+// Moves off the board, on an occupied cell or after the end of the game are rejected by the
+// server and the AI, and the game goes on unchanged
+void
+test_illegal_moves_are_rejected( )
+{
+    auto const size = TicTacToeGame::BOARD_SIZE;
+    const MatchServer::AvailableCells available( size, std::vector< bool >( size, true ) );
+    MatchSettings settings;
+    settings.search.iterations = 1000;
+    MatchServer server( settings );
+    auto const game = server.create_game( available );
+    TicTacToeGameAI ai( available, 1000 );
+
+    auto server_state = TicTacToeGame::make_state( 0, 0, true );
+    auto ai_state = server_state;
+    auto ai_position = ai.get_my_move( );
+    auto ai_move = ai_position.row * size + ai_position.col;
+    CHECK( is_legal< TicTacToeGame >( ai_state, ai_move ) );
+    TicTacToeGame::play( ai_state, ai_move );
+    for ( auto move = get_reply( server.get_my_move( game ), server_state ); move >= 0; )
+    {
+        TicTacToeGame::play( server_state, move );
+        for ( const MovePosition illegal : {MovePosition{20, 20}, MovePosition{-1, size + 1},
+                                            MovePosition{move / size, move % size}} )
+        {
+            CHECK( is_rejected( [&] { server.opponent_move( game, illegal ).get( ); } ) );
+        }
+        CHECK( is_rejected( [&] { ai.opponent_move( {20, 20} ); } ) );
+        CHECK( is_rejected( [&] { ai.opponent_move( {ai_move / size, ai_move % size} ); } ) );
+        if ( is_finished< TicTacToeGame >( server_state ) )
+        {
+            break;
+        }
+
+        TicTacToeGame::Moves moves;
+        TicTacToeGame::get_moves( server_state, moves );
+        TicTacToeGame::play( server_state, moves[ 0 ] );
+        move = get_reply( server.opponent_move( game, {moves[ 0 ] / size, moves[ 0 ] % size} ),
+                          server_state );
+
+        if ( !is_finished< TicTacToeGame >( ai_state ) )
+        {
+            TicTacToeGame::get_moves( ai_state, moves );
+            TicTacToeGame::play( ai_state, moves[ 0 ] );
+            ai.opponent_move( {moves[ 0 ] / size, moves[ 0 ] % size} );
+            if ( !is_finished< TicTacToeGame >( ai_state ) )
+            {
+                ai_position = ai.get_my_move( );
+                ai_move = ai_position.row * size + ai_position.col;
+                CHECK( is_legal< TicTacToeGame >( ai_state, ai_move ) );
+                TicTacToeGame::play( ai_state, ai_move );
+            }
+        }
+    }
+
+    for ( Move move = 0; move < size * size; ++move )
+    {
+        CHECK( is_rejected(
+            [&] { server.opponent_move( game, {move / size, move % size} ).get( ); } ) );
+    }
+}
+
+// Once the opponent finished the game the AI has no move, like a reply of the server, and does
+// not ponder
+void
+test_ai_reports_finished_games( )
+{
+    auto const size = TicTacToeGame::BOARD_SIZE;
+    SearchSettings settings;
+    settings.iterations = 1000;
+    settings.ponder = true;
+
+    // The opponent already owns the first row
+    TicTacToeGameAI::AvailableCells available( size, std::vector< bool >( size, true ) );
+    available[ 0 ] = {false, false, false};
+    CHECK( TicTacToeGameAI( available, settings ).get_my_move( ).row < 0 );
+
+    // The opponent threatens five lines and completes one the AI did not block
+    available = TicTacToeGameAI::AvailableCells( size, std::vector< bool >( size, true ) );
+    available[ 0 ][ 0 ] = available[ 0 ][ 1 ] = available[ 1 ][ 0 ] = available[ 1 ][ 1 ] = false;
+    TicTacToeGameAI ai( available, settings );
+    auto const blocked = ai.get_my_move( );
+    CHECK( blocked.row >= 0 );
+    for ( const MovePosition win : {MovePosition{0, 2}, MovePosition{1, 2}, MovePosition{2, 0},
+                                    MovePosition{2, 1}, MovePosition{2, 2}} )
+    {
+        if ( win.row != blocked.row || win.col != blocked.col )
+        {
+            ai.opponent_move( win );
+            break;
+        }
+    }
+    CHECK( ai.get_my_move( ).row < 0 && ai.get_my_move( ).col < 0 );
+}
+
+// The virtual adapter searches like the game it wraps, proves a win in one move and refuses to
+// play a move that is not legal
+void
+test_virtual_game_search( )
+{
+    using bitboard::cell_mask;
+    auto const position = TicTacToeGame::make_state( cell_mask( 0 ) | cell_mask( 1 ),
+                                                     cell_mask( 3 ) | cell_mask( 4 ), true );
+    MctsTree tree( VirtualGame::State( std::unique_ptr< MctsState >(
+                       new GameState< TicTacToeGame >( position ) ) ),
+                   1 << 10 );
+    RandomEngine random( 1 );
+    for ( int i = 0; i < 2000 && !tree.is_solved( ); ++i )
+    {
+        tree.choose_child( random );
+    }
+    CHECK( tree.is_solved( ) && tree.get_root( )->get_proof( ) == Proof::e_Proof_Hit );
+
+    bool found = false;
+    tree.get_root( )->visit_children( [&]( Move move, int, int, Proof proof ) {
+        CHECK( is_legal< TicTacToeGame >( position, move ) );
+        found = found || ( move == 2 && proof == Proof::e_Proof_Hit );
+    } );
+    CHECK( found );
+
+    CHECK( is_rejected( [&] {
+        auto state = tree.get_state( );
+        VirtualGame::play( state, 3 );
+    } ) );
+    tree.reroot( 2 );
+    CHECK( !VirtualGame::is_my_turn( tree.get_state( ) ) );
+    VirtualGame::Moves moves;
+    VirtualGame::get_moves( tree.get_state( ), moves );
+    CHECK( moves.empty( ) );
+}
+
+}  // namespace
+
+int
+main( )
+{
+    for ( uint64_t seed = 1; seed <= 5; ++seed )
+    {
+        test_recycling_keeps_moves_legal< TicTacToeGame >( TicTacToeGame::make_state( 0, 0, true ),
+                                                           seed );
+        test_recycling_keeps_moves_legal< TicTacToeBigGame >(
+            TicTacToeBigGame::make_state( TicTacToeBigGame::Boards{}, TicTacToeBigGame::Boards{},
+                                          true ),
+            seed );
+    }
+
+    test_book_plays_proven_wins( );
+
+    test_snapshot_round_trip( );
+
+    test_server_replies_in_solved_positions( false );
+    test_server_replies_in_solved_positions( true );
+
+    test_ucb1_selection( );
+
+    test_incremental_results( );
+
+    test_illegal_moves_are_rejected( );
+
+    test_ai_reports_finished_games( );
+
+    test_virtual_game_search( );
+
+    if ( failures > 0 )
+    {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all checks passed" << std::endl;
+    return 0;
+}
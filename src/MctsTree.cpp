@@ -0,0 +1,50 @@
+#include "MctsTree.h"
+
+#include <stdexcept>
+
+namespace mcts
+{
+VirtualGame::State::State( std::unique_ptr< MctsState > state )
+    : position( std::move( state ) )
+{
+}
+
+void
+VirtualGame::get_moves( const State& state, Moves& moves )
+{
+    for ( auto const& child : state.position->get_children( ) )
+    {
+        moves.push_back( child->get_move( ) );
+    }
+}
+
+void
+VirtualGame::play( State& state, Move move )
+{
+    auto child = state.position->play( move );
+    if ( !child )
+    {
+        throw std::invalid_argument( "move is not legal in this position" );
+    }
+    state.position = std::move( child );
+}
+
+MctsState::Result
+VirtualGame::simulate( const State& state, RandomEngine& random )
+{
+    return state.position->simulate( random );
+}
+
+bool
+VirtualGame::is_my_turn( const State& state )
+{
+    return state.position->is_my_turn( );
+}
+
+Hash
+VirtualGame::get_hash( const State& state )
+{
+    return state.position->get_hash( );
+}
+
+}  // namespace mcts
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Mcts.h"
+
+#include <memory>
+#include <vector>
+
+namespace mcts
+{
+// Plugs the virtual MctsState interface into the Mcts< Game > template. Positions are immutable
+// and shared by all copies of a state, replaying a path asks every position only for the state
+// after the played move, which is released once no iteration refers to it.
+struct VirtualGame
+{
+    using Moves = std::vector< Move >;
+
+    struct State
+    {
+        State( ) = default;
+        State( std::unique_ptr< MctsState > state );
+
+        std::shared_ptr< const MctsState > position;
+    };
+
+    static void get_moves( const State& state, Moves& moves );
+    // Throws std::invalid_argument when `move` is not legal in `state`
+    static void play( State& state, Move move );
+    static MctsState::Result simulate( const State& state, RandomEngine& random );
+    static bool is_my_turn( const State& state );
+    static Hash get_hash( const State& state );
+};
+
+using MctsTree = Mcts< VirtualGame >;
+using MctsNode = MctsTree::Node;
+using MctsNodePtr = MctsTree::NodePtr;
+
+}  // namespace mcts
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "MctsState.h"
+
+#include <array>
+#include <cstddef>
+
+namespace mcts
+{
+// Move list of a game with at most `CAPACITY` legal moves, kept on the stack
+template < size_t CAPACITY >
+struct MoveList
+{
+    using value_type = Move;
+    using iterator = Move*;
+    using const_iterator = const Move*;
+
+    void
+    push_back( Move move )
+    {
+        m_moves[ m_size++ ] = move;
+    }
+
+    void
+    clear( )
+    {
+        m_size = 0;
+    }
+
+    size_t
+    size( ) const
+    {
+        return m_size;
+    }
+
+    bool
+    empty( ) const
+    {
+        return m_size == 0;
+    }
+
+    Move
+    operator[]( size_t index ) const
+    {
+        return m_moves[ index ];
+    }
+
+    iterator
+    begin( )
+    {
+        return m_moves.data( );
+    }
+
+    iterator
+    end( )
+    {
+        return m_moves.data( ) + m_size;
+    }
+
+    const_iterator
+    begin( ) const
+    {
+        return m_moves.data( );
+    }
+
+    const_iterator
+    end( ) const
+    {
+        return m_moves.data( ) + m_size;
+    }
+
+private:
+    std::array< Move, CAPACITY > m_moves;
+    size_t m_size = 0;
+};
+
+}  // namespace mcts
@@ -0,0 +1,122 @@
+#include "OpeningBook.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace mcts
+{
+namespace
+{
+const char MAGIC[ 8 ] = {'M', 'C', 'T', 'S', 'B', 'O', 'O', 'K'};
+
+bool
+is_before( const OpeningBook::Record& lhs, const OpeningBook::Record& rhs )
+{
+    return lhs.hash < rhs.hash || ( lhs.hash == rhs.hash && lhs.move < rhs.move );
+}
+
+}  // namespace
+
+OpeningBook::OpeningBook( )
+    : m_records( nullptr )
+    , m_record_count( 0 )
+{
+}
+
+OpeningBook::~OpeningBook( )
+{
+    close( );
+}
+
+bool
+OpeningBook::open( const std::string& path, int board_size )
+{
+    close( );
+
+    if ( !m_file.open( path ) )
+    {
+        return false;
+    }
+
+    auto const data = m_file.data( );
+    auto const size = m_file.size( );
+    Header header;
+    if ( size < sizeof( header ) )
+    {
+        close( );
+        return false;
+    }
+
+    std::memcpy( &header, data, sizeof( header ) );
+    if ( std::memcmp( header.magic, MAGIC, sizeof( MAGIC ) ) != 0 || header.version != VERSION
+         || header.board_size != static_cast< uint32_t >( board_size )
+         || ( size - sizeof( header ) ) / sizeof( Record ) < header.record_count )
+    {
+        close( );
+        return false;
+    }
+
+    m_records = reinterpret_cast< const Record* >( static_cast< const char* >( data )
+                                                   + sizeof( header ) );
+    m_record_count = static_cast< size_t >( header.record_count );
+    return true;
+}
+
+bool
+OpeningBook::is_open( ) const
+{
+    return m_records != nullptr;
+}
+
+std::pair< const OpeningBook::Record*, const OpeningBook::Record* >
+OpeningBook::find( Hash hash ) const
+{
+    auto const end = m_records + m_record_count;
+    auto const first
+        = std::lower_bound( m_records, end, hash, []( const Record& record, Hash value ) {
+              return record.hash < value;
+          } );
+    auto last = first;
+    while ( last != end && last->hash == hash )
+    {
+        ++last;
+    }
+    return {first, last};
+}
+
+size_t
+OpeningBook::size( ) const
+{
+    return m_record_count;
+}
+
+bool
+OpeningBook::write( const std::string& path, int board_size, std::vector< Record > records )
+{
+    static_assert( sizeof( Header ) % alignof( Record ) == 0, "records follow the header aligned" );
+
+    std::sort( records.begin( ), records.end( ), is_before );
+
+    Header header;
+    std::memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+    header.version = VERSION;
+    header.board_size = static_cast< uint32_t >( board_size );
+    header.record_count = records.size( );
+
+    std::ofstream file( path, std::ios::binary | std::ios::trunc );
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+    file.write( reinterpret_cast< const char* >( records.data( ) ),
+                static_cast< std::streamsize >( records.size( ) * sizeof( Record ) ) );
+    return static_cast< bool >( file );
+}
+
+void
+OpeningBook::close( )
+{
+    m_file.close( );
+    m_records = nullptr;
+    m_record_count = 0;
+}
+
+}  // namespace mcts
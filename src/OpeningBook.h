@@ -0,0 +1,65 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "MctsState.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mcts
+{
+// Statistics of the moves of early positions, searched offline by build_opening_book and keyed
+// by the position hash of the side to move. The file is a header followed by fixed-size records
+// sorted by hash and move, in the byte order of the machine that wrote it. It is mapped into
+// memory where the platform supports it and read as a whole otherwise.
+struct OpeningBook
+{
+    struct Record
+    {
+        Hash hash;
+        int32_t move;
+        // Two per won playout and one per draw for the side to move
+        uint32_t hits;
+        uint32_t trials;
+        // Proof of the position after the move, a proven win is played regardless of trials
+        int32_t proof;
+    };
+
+    OpeningBook( );
+    ~OpeningBook( );
+
+    OpeningBook( const OpeningBook& ) = delete;
+    OpeningBook& operator=( const OpeningBook& ) = delete;
+
+    // False when the file cannot be read or was written for another board size
+    bool open( const std::string& path, int board_size );
+    bool is_open( ) const;
+    // Records of the position, both pointers are equal when it is not in the book
+    std::pair< const Record*, const Record* > find( Hash hash ) const;
+    size_t size( ) const;
+
+    // Records may come in any order
+    static bool write( const std::string& path, int board_size, std::vector< Record > records );
+
+private:
+    struct Header
+    {
+        char magic[ 8 ];
+        uint32_t version;
+        uint32_t board_size;
+        uint64_t record_count;
+    };
+
+    static const uint32_t VERSION = 3;
+
+    void close( );
+
+private:
+    MappedFile m_file;
+    const Record* m_records;
+    size_t m_record_count;
+};
+
+}  // namespace mcts
@@ -0,0 +1,168 @@
+#include "MctsSearch.h"
+#include "OpeningBook.h"
+#include "TicTacToeBigGame.h"
+
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <thread>
+#include <unordered_set>
+
+// Searches the early positions of one game deeply and writes the statistics of their moves to
+// an opening book
+//
+//     build_opening_book <output> [board_size] [ai_moves] [iterations] [threads]
+//
+// The book covers the first `ai_moves` moves of the AI, whether it starts or replies to any
+// first move of the opponent, and every reply of the opponent to the moves of the book.
+
+namespace
+{
+using namespace mcts;
+
+template < typename Game >
+struct BookBuilder
+{
+    using State = typename Game::State;
+
+    explicit BookBuilder( const SearchSettings& settings )
+        : m_settings( settings )
+    {
+    }
+
+    std::vector< OpeningBook::Record >
+    build( const std::vector< State >& starts, int ai_moves )
+    {
+        std::deque< std::pair< State, int > > pending;
+        for ( auto const& start : starts )
+        {
+            pending.emplace_back( start, 1 );
+        }
+
+        // Positions that transpose are searched once
+        std::unordered_set< Hash > searched;
+        std::vector< OpeningBook::Record > records;
+        while ( !pending.empty( ) )
+        {
+            auto const state = pending.front( ).first;
+            auto const depth = pending.front( ).second;
+            pending.pop_front( );
+            if ( !searched.insert( Game::get_hash( state ) ).second )
+            {
+                continue;
+            }
+
+            auto const best = search( state, records );
+            if ( best < 0 || depth >= ai_moves )
+            {
+                continue;
+            }
+
+            auto after_best = state;
+            Game::play( after_best, best );
+            typename Game::Moves replies;
+            Game::get_moves( after_best, replies );
+            for ( auto const reply : replies )
+            {
+                auto next = after_best;
+                Game::play( next, reply );
+                pending.emplace_back( next, depth + 1 );
+            }
+        }
+        return records;
+    }
+
+private:
+    // Adds the records of `state` and returns its best move, -1 for a finished game
+    Move
+    search( const State& state, std::vector< OpeningBook::Record >& records )
+    {
+        GameSearch< Game > search( state, m_settings );
+        std::atomic< bool > const stop( false );
+        search.search( m_settings.iterations, MctsSearch::Clock::time_point::max( ), stop );
+        for ( auto const& child : search.get_statistics( ).root_children )
+        {
+            records.push_back( {Game::get_hash( state ), child.move,
+                                static_cast< uint32_t >( child.hits ),
+                                static_cast< uint32_t >( child.total_trials ),
+                                static_cast< int32_t >( child.proof )} );
+        }
+        return search.get_best_move( );
+    }
+
+private:
+    const SearchSettings m_settings;
+};
+
+// The AI moves first, or second after any first move of the opponent
+std::vector< TicTacToeGame::State >
+get_start_states( TicTacToeGame* )
+{
+    std::vector< TicTacToeGame::State > starts{TicTacToeGame::make_state( 0, 0, true )};
+    for ( int cell = 0; cell < bitboard::CELLS; ++cell )
+    {
+        starts.push_back( TicTacToeGame::make_state( 0, bitboard::cell_mask( cell ), true ) );
+    }
+    return starts;
+}
+
+// Like TicTacToeGameAI the opponent's first move does not select the board of the AI
+std::vector< TicTacToeBigGame::State >
+get_start_states( TicTacToeBigGame* )
+{
+    TicTacToeBigGame::Boards const empty{};
+    std::vector< TicTacToeBigGame::State > starts{
+        TicTacToeBigGame::make_state( empty, empty, true )};
+    for ( int board = 0; board < bitboard::CELLS; ++board )
+    {
+        for ( int cell = 0; cell < bitboard::CELLS; ++cell )
+        {
+            auto opponent = empty;
+            opponent[ board ] = bitboard::cell_mask( cell );
+            starts.push_back( TicTacToeBigGame::make_state( empty, opponent, true ) );
+        }
+    }
+    return starts;
+}
+
+template < typename Game >
+std::vector< OpeningBook::Record >
+build_book( const SearchSettings& settings, int ai_moves )
+{
+    return BookBuilder< Game >( settings ).build(
+        get_start_states( static_cast< Game* >( nullptr ) ), ai_moves );
+}
+
+}  // namespace
+
+int
+main( int argc, char** argv )
+{
+    if ( argc < 2 )
+    {
+        std::cerr << "usage: " << argv[ 0 ]
+                  << " <output> [board_size] [ai_moves] [iterations] [threads]" << std::endl;
+        return 1;
+    }
+
+    std::string const output = argv[ 1 ];
+    auto const board_size = argc > 2 ? std::atoi( argv[ 2 ] ) : TicTacToeBigGame::BOARD_SIZE;
+    auto const ai_moves = argc > 3 ? std::atoi( argv[ 3 ] ) : 2;
+
+    SearchSettings settings;
+    settings.iterations = argc > 4 ? std::strtoul( argv[ 4 ], nullptr, 10 ) : 100000;
+    settings.threads = argc > 5 ? std::strtoul( argv[ 5 ], nullptr, 10 )
+                                : std::max( std::thread::hardware_concurrency( ), 1u );
+    settings.collect_statistics = true;
+
+    auto const records = board_size == TicTacToeGame::BOARD_SIZE
+                             ? build_book< TicTacToeGame >( settings, ai_moves )
+                             : build_book< TicTacToeBigGame >( settings, ai_moves );
+    if ( !OpeningBook::write( output, board_size, records ) )
+    {
+        std::cerr << "cannot write " << output << std::endl;
+        return 1;
+    }
+
+    std::cout << records.size( ) << " moves written to " << output << std::endl;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace mcts
+{
+// Advances `state` and returns the next splitmix64 output
+inline uint64_t
+splitmix64( uint64_t& state )
+{
+    uint64_t z = ( state += 0x9e3779b97f4a7c15ull );
+    z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+    z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+    return z ^ ( z >> 31 );
+}
+
+// xoshiro256** generator, small and fast enough to give every search thread its own.
+// Satisfies UniformRandomBitGenerator, so it works with <random> and <algorithm>.
+struct Xoshiro256
+{
+    using result_type = uint64_t;
+
+    explicit Xoshiro256( uint64_t seed = 0 )
+    {
+        this->seed( seed );
+    }
+
+    void
+    seed( uint64_t seed )
+    {
+        for ( auto& word : m_state )
+        {
+            word = splitmix64( seed );
+        }
+    }
+
+    static constexpr result_type
+    min( )
+    {
+        return 0;
+    }
+
+    static constexpr result_type
+    max( )
+    {
+        return std::numeric_limits< result_type >::max( );
+    }
+
+    result_type
+    operator( )( )
+    {
+        auto const result = rotl( m_state[ 1 ] * 5, 7 ) * 9;
+        auto const t = m_state[ 1 ] << 17;
+        m_state[ 2 ] ^= m_state[ 0 ];
+        m_state[ 3 ] ^= m_state[ 1 ];
+        m_state[ 1 ] ^= m_state[ 2 ];
+        m_state[ 0 ] ^= m_state[ 3 ];
+        m_state[ 2 ] ^= t;
+        m_state[ 3 ] = rotl( m_state[ 3 ], 45 );
+        return result;
+    }
+
+    // Skips 2^128 outputs, generators jumped a different number of times never overlap
+    void
+    jump( )
+    {
+        static const uint64_t JUMP[] = {0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull,
+                                        0xa9582618e03fc9aaull, 0x39abdc4529b1661cull};
+        uint64_t state[ 4 ] = {0, 0, 0, 0};
+        for ( auto const jump : JUMP )
+        {
+            for ( int bit = 0; bit < 64; ++bit )
+            {
+                if ( jump & ( uint64_t( 1 ) << bit ) )
+                {
+                    for ( int i = 0; i < 4; ++i )
+                    {
+                        state[ i ] ^= m_state[ i ];
+                    }
+                }
+                ( *this )( );
+            }
+        }
+        for ( int i = 0; i < 4; ++i )
+        {
+            m_state[ i ] = state[ i ];
+        }
+    }
+
+private:
+    static uint64_t
+    rotl( uint64_t x, int k )
+    {
+        return ( x << k ) | ( x >> ( 64 - k ) );
+    }
+
+private:
+    uint64_t m_state[ 4 ];
+};
+
+// Uniform integer in [0, bound) without modulo bias, `bound` must be positive.
+// Lemire's multiply-and-shift method, which only divides when a sample has to be rejected.
+template < typename Engine >
+uint32_t
+bounded( Engine& random, uint32_t bound )
+{
+    uint64_t product = uint64_t( static_cast< uint32_t >( random( ) >> 32 ) ) * bound;
+    auto low = static_cast< uint32_t >( product );
+    if ( low < bound )
+    {
+        auto const threshold = static_cast< uint32_t >( -bound ) % bound;
+        while ( low < threshold )
+        {
+            product = uint64_t( static_cast< uint32_t >( random( ) >> 32 ) ) * bound;
+            low = static_cast< uint32_t >( product );
+        }
+    }
+    return static_cast< uint32_t >( product >> 32 );
+}
+
+}  // namespace mcts
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace mcts
+{
+// Allocates objects in large contiguous slabs. Objects are never freed one by one, the whole
+// pool is released at once. Allocation is thread safe, construction happens outside the lock.
+// The size is read without the lock, so searches can check it on every expansion.
+template < typename T >
+struct SlabPool
+{
+    explicit SlabPool( size_t slab_size = 4096 );
+    ~SlabPool( );
+
+    SlabPool( const SlabPool& ) = delete;
+    SlabPool& operator=( const SlabPool& ) = delete;
+
+    // Places `count` adjacent objects, `construct( place, index )` must construct each of them
+    template < typename Construct >
+    T* create( size_t count, Construct construct );
+    size_t size( ) const;
+    // Bytes reserved by all slabs
+    size_t get_memory_usage( ) const;
+    void clear( );
+    // Exchanges the objects of both pools, neither pool may be used concurrently
+    void swap( SlabPool& other );
+
+private:
+    using Storage = typename std::aligned_storage< sizeof( T ), alignof( T ) >::type;
+
+    struct Slab
+    {
+        std::unique_ptr< Storage[] > storage;
+        size_t used;
+        size_t capacity;
+    };
+
+    T* allocate( size_t count );
+
+private:
+    const size_t m_slab_size;
+    std::vector< Slab > m_slabs;
+    std::atomic< size_t > m_size;
+    mutable std::mutex m_mutex;
+};
+
+template < typename T >
+SlabPool< T >::SlabPool( size_t slab_size )
+    : m_slab_size( slab_size )
+    , m_size( 0 )
+{
+}
+
+template < typename T >
+SlabPool< T >::~SlabPool( )
+{
+    clear( );
+}
+
+template < typename T >
+template < typename Construct >
+T*
+SlabPool< T >::create( size_t count, Construct construct )
+{
+    auto objects = allocate( count );
+    for ( size_t i = 0; i < count; ++i )
+    {
+        construct( objects + i, i );
+    }
+    return objects;
+}
+
+template < typename T >
+size_t
+SlabPool< T >::size( ) const
+{
+    return m_size.load( std::memory_order_relaxed );
+}
+
+template < typename T >
+size_t
+SlabPool< T >::get_memory_usage( ) const
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    size_t capacity = 0;
+    for ( auto const& slab : m_slabs )
+    {
+        capacity += slab.capacity;
+    }
+    return capacity * sizeof( Storage );
+}
+
+template < typename T >
+void
+SlabPool< T >::clear( )
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    for ( auto& slab : m_slabs )
+    {
+        for ( size_t i = 0; i < slab.used; ++i )
+        {
+            reinterpret_cast< T* >( &slab.storage[ i ] )->~T( );
+        }
+    }
+    m_slabs.clear( );
+    m_size.store( 0, std::memory_order_relaxed );
+}
+
+template < typename T >
+void
+SlabPool< T >::swap( SlabPool& other )
+{
+    m_slabs.swap( other.m_slabs );
+    m_size.store( other.m_size.exchange( m_size.load( std::memory_order_relaxed ),
+                                         std::memory_order_relaxed ),
+                  std::memory_order_relaxed );
+}
+
+template < typename T >
+T*
+SlabPool< T >::allocate( size_t count )
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+
+    if ( m_slabs.empty( ) || m_slabs.back( ).capacity - m_slabs.back( ).used < count )
+    {
+        auto const capacity = std::max( m_slab_size, count );
+        m_slabs.push_back(
+            Slab{std::unique_ptr< Storage[] >( new Storage[ capacity ] ), 0, capacity} );
+    }
+
+    auto& slab = m_slabs.back( );
+    auto objects = reinterpret_cast< T* >( &slab.storage[ slab.used ] );
+    slab.used += count;
+    m_size.fetch_add( count, std::memory_order_relaxed );
+    return objects;
+}
+
+}  // namespace mcts
@@ -0,0 +1,72 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace mcts
+{
+ThreadPool::ThreadPool( size_t threads )
+    : m_stop( false )
+{
+    threads = std::max< size_t >( threads, 1 );
+    for ( size_t i = 0; i < threads; ++i )
+    {
+        m_threads.emplace_back( &ThreadPool::run, this );
+    }
+}
+
+ThreadPool::~ThreadPool( )
+{
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        m_stop = true;
+    }
+    m_wakeup.notify_all( );
+
+    for ( auto& thread : m_threads )
+    {
+        thread.join( );
+    }
+}
+
+void
+ThreadPool::submit( Task task )
+{
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        if ( m_stop )
+        {
+            return;
+        }
+        m_tasks.push_back( std::move( task ) );
+    }
+    m_wakeup.notify_one( );
+}
+
+size_t
+ThreadPool::get_thread_count( ) const
+{
+    return m_threads.size( );
+}
+
+void
+ThreadPool::run( )
+{
+    while ( true )
+    {
+        Task task;
+        {
+            std::unique_lock< std::mutex > lock( m_mutex );
+            m_wakeup.wait( lock, [this]( ) { return m_stop || !m_tasks.empty( ); } );
+            if ( m_stop )
+            {
+                return;
+            }
+            task = std::move( m_tasks.front( ) );
+            m_tasks.pop_front( );
+        }
+
+        task( );
+    }
+}
+
+}  // namespace mcts
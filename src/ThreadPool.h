@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mcts
+{
+// Fixed set of threads sharing one task queue under one lock. Tasks start in the order they were
+// submitted, also those submitted by a pool thread, so a task that queues its continuation lets
+// every task submitted before it run first.
+struct ThreadPool
+{
+    using Task = std::function< void( ) >;
+
+    explicit ThreadPool( size_t threads );
+    // Waits for the running tasks, queued tasks are dropped
+    ~ThreadPool( );
+
+    ThreadPool( const ThreadPool& ) = delete;
+    ThreadPool& operator=( const ThreadPool& ) = delete;
+
+    // Dropped once the pool is being destroyed
+    void submit( Task task );
+    size_t get_thread_count( ) const;
+
+private:
+    void run( );
+
+private:
+    std::vector< std::thread > m_threads;
+    std::deque< Task > m_tasks;
+    bool m_stop;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+};
+
+}  // namespace mcts
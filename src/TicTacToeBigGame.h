@@ -0,0 +1,284 @@
+#pragma once
+
+#include "TicTacToeGame.h"
+
+#include <array>
+
+namespace mcts
+{
+// Ultimate tic-tac-toe for the Mcts< Game > template, a move is row * 9 + col on the big board.
+// Every small board is a pair of 9-bit masks, the meta board tracks finished small boards with
+// the same masks. A move only checks the lines through its cell on its small board and, when
+// that board is won, the lines through the board on the meta board.
+struct TicTacToeBigGame
+{
+    using Mask = bitboard::Mask;
+    using Boards = std::array< Mask, bitboard::CELLS >;
+
+    static constexpr int BOARD_SIZE = bitboard::SIZE * bitboard::SIZE;
+    static constexpr int MAX_MOVES = BOARD_SIZE * BOARD_SIZE;
+
+    using Moves = MoveList< MAX_MOVES >;
+
+    struct State
+    {
+        Boards mine;
+        Boards opponent;
+        // Meta board
+        Mask won_mine;
+        Mask won_opponent;
+        Mask drawn;
+        // Board the next move has to be played on, -1 for any open board
+        int target_board;
+        bool my_turn;
+        // Zobrist hash of the marks and the side to move, updated on every move
+        Hash hash;
+        // Result of the meta board, updated on every move
+        MctsState::Result result;
+    };
+
+    // `last_move` selects the board of the next move, -1 when any board may be chosen
+    static State
+    make_state( const Boards& mine, const Boards& opponent, bool my_turn, Move last_move = -1 )
+    {
+        State state{mine,
+                    opponent,
+                    0,
+                    0,
+                    0,
+                    -1,
+                    my_turn,
+                    my_turn ? 0 : zobrist::side_key( ),
+                    MctsState::Result::e_Result_NotFinished};
+        for ( int board = 0; board < bitboard::CELLS; ++board )
+        {
+            set_board_result( state, board,
+                              TicTacToeGame::get_result( mine[ board ], opponent[ board ] ) );
+            state.hash ^= TicTacToeGame::get_hash( mine[ board ], opponent[ board ],
+                                                   board * bitboard::CELLS );
+        }
+        state.result = get_meta_result( state );
+        update_target_board( state, last_move );
+        return state;
+    }
+
+    // True when `state` holds a position of the game whose meta board, hash and result match its
+    // marks and whose target board is open. Checked like TicTacToeGame::is_valid( ).
+    static bool
+    is_valid( const State& state )
+    {
+        if ( !TicTacToeGame::is_valid_turn( state.my_turn ) || state.target_board < -1
+             || state.target_board >= bitboard::CELLS )
+        {
+            return false;
+        }
+        for ( int board = 0; board < bitboard::CELLS; ++board )
+        {
+            if ( !TicTacToeGame::is_valid_board( state.mine[ board ], state.opponent[ board ] ) )
+            {
+                return false;
+            }
+        }
+
+        auto const expected = make_state( state.mine, state.opponent, state.my_turn );
+        auto const finished = expected.won_mine | expected.won_opponent | expected.drawn;
+        return state.won_mine == expected.won_mine && state.won_opponent == expected.won_opponent
+               && state.drawn == expected.drawn && state.hash == expected.hash
+               && state.result == expected.result
+               && ( state.target_board < 0
+                    || ( finished & bitboard::cell_mask( state.target_board ) ) == 0 );
+    }
+
+    static MctsState::Result
+    get_result( const State& state )
+    {
+        return state.result;
+    }
+
+    // Scans all lines of the meta board, positions that are played into are updated by play( ).
+    // The game is drawn once every small board is won or drawn without a line on the meta board.
+    static MctsState::Result
+    get_meta_result( const State& state )
+    {
+        if ( bitboard::is_win( state.won_mine ) )
+        {
+            return MctsState::Result::e_Result_Hit;
+        }
+
+        if ( bitboard::is_win( state.won_opponent ) )
+        {
+            return MctsState::Result::e_Result_Miss;
+        }
+
+        return ( state.won_mine | state.won_opponent | state.drawn ) == bitboard::FULL
+                   ? MctsState::Result::e_Result_Draw
+                   : MctsState::Result::e_Result_NotFinished;
+    }
+
+    static void
+    get_moves( const State& state, Moves& moves )
+    {
+        if ( state.result != MctsState::Result::e_Result_NotFinished )
+        {
+            return;
+        }
+
+        auto const targets = state.target_board < 0
+                                 ? bitboard::FULL
+                                       & ~( state.won_mine | state.won_opponent | state.drawn )
+                                 : bitboard::cell_mask( state.target_board );
+        for ( Mask boards = targets; boards; boards &= boards - 1 )
+        {
+            auto const board = bitboard::lowest( boards );
+            for ( Mask available
+                  = bitboard::FULL & ~( state.mine[ board ] | state.opponent[ board ] );
+                  available; available &= available - 1 )
+            {
+                moves.push_back( get_move( board, bitboard::lowest( available ) ) );
+            }
+        }
+    }
+
+    static void
+    play( State& state, Move move )
+    {
+        auto const board = get_board( move );
+        auto const cell = get_cell( move );
+
+        ( state.my_turn ? state.mine : state.opponent )[ board ] |= bitboard::cell_mask( cell );
+        update_board_result( state, board, cell );
+        state.hash ^= zobrist::cell_key( board * bitboard::CELLS + cell, state.my_turn )
+                      ^ zobrist::side_key( );
+        update_target_board( state, move );
+        state.my_turn = !state.my_turn;
+    }
+
+    static MctsState::Result
+    simulate( const State& state, RandomEngine& random )
+    {
+        if ( state.result != MctsState::Result::e_Result_NotFinished )
+        {
+            return state.result;
+        }
+
+        return TicTacToeBigGamePlayout( state.mine, state.opponent, state.won_mine,
+                                        state.won_opponent, state.drawn, state.target_board,
+                                        state.my_turn )
+            .run( random );
+    }
+
+    static bool
+    is_my_turn( const State& state )
+    {
+        return state.my_turn;
+    }
+
+    static Hash
+    get_hash( const State& state )
+    {
+        // The same marks with a different forced board are a different position
+        return state.hash ^ zobrist::target_key( state.target_board );
+    }
+
+    // Index of the small board of `move`
+    static int
+    get_board( Move move )
+    {
+        return bitboard::cell_index( move / BOARD_SIZE / bitboard::SIZE,
+                                     move % BOARD_SIZE / bitboard::SIZE );
+    }
+
+    // Index of the cell of `move` inside its small board
+    static int
+    get_cell( Move move )
+    {
+        return bitboard::cell_index( move / BOARD_SIZE % bitboard::SIZE,
+                                     move % BOARD_SIZE % bitboard::SIZE );
+    }
+
+    static Move
+    get_move( int board, int cell )
+    {
+        return ( board / bitboard::SIZE * bitboard::SIZE + cell / bitboard::SIZE ) * BOARD_SIZE
+               + board % bitboard::SIZE * bitboard::SIZE + cell % bitboard::SIZE;
+    }
+
+private:
+    // Only the lines through `cell` and, once its board is won, the lines through `board` on the
+    // meta board can change
+    static void
+    update_board_result( State& state, int board, int cell )
+    {
+        auto const result = TicTacToeGame::get_result_after(
+            state.mine[ board ], state.opponent[ board ], cell, state.my_turn );
+        set_board_result( state, board, result );
+
+        auto const won = state.my_turn ? state.won_mine : state.won_opponent;
+        if ( ( won & bitboard::cell_mask( board ) ) && bitboard::is_win_through( won, board ) )
+        {
+            state.result = result;
+        }
+        else if ( ( state.won_mine | state.won_opponent | state.drawn ) == bitboard::FULL )
+        {
+            state.result = MctsState::Result::e_Result_Draw;
+        }
+    }
+
+    static void
+    set_board_result( State& state, int board, MctsState::Result result )
+    {
+        auto const board_mask = bitboard::cell_mask( board );
+
+        switch ( result )
+        {
+        case MctsState::Result::e_Result_Hit:
+            state.won_mine |= board_mask;
+            break;
+        case MctsState::Result::e_Result_Miss:
+            state.won_opponent |= board_mask;
+            break;
+        case MctsState::Result::e_Result_Draw:
+            state.drawn |= board_mask;
+            break;
+        case MctsState::Result::e_Result_NotFinished:
+            break;
+        }
+    }
+
+    // The cell position inside its small board selects the board for the next move,
+    // all boards are possible once it is finished
+    static void
+    update_target_board( State& state, Move last_move )
+    {
+        if ( last_move < 0 )
+        {
+            state.target_board = -1;
+            return;
+        }
+
+        auto const target = get_cell( last_move );
+        auto const finished = state.won_mine | state.won_opponent | state.drawn;
+        state.target_board = ( finished & bitboard::cell_mask( target ) ) ? -1 : target;
+    }
+};
+
+// TicTacToeBigGame whose playouts follow the tactical policy of
+// TicTacToeBigGamePlayout::run_tactical( ) instead of random moves
+struct TacticalTicTacToeBigGame : public TicTacToeBigGame
+{
+    static MctsState::Result
+    simulate( const State& state, RandomEngine& random )
+    {
+        if ( state.result != MctsState::Result::e_Result_NotFinished )
+        {
+            return state.result;
+        }
+
+        return TicTacToeBigGamePlayout( state.mine, state.opponent, state.won_mine,
+                                        state.won_opponent, state.drawn, state.target_board,
+                                        state.my_turn )
+            .run_tactical( random );
+    }
+};
+
+}  // namespace mcts
@@ -1,31 +1,21 @@
 #pragma once
 
+#include "TicTacToeBigGame.h"
 #include "TicTacToeState.h"
 
 namespace mcts
 {
-struct TicTacToeBigGameState : public TicTacToeState
+struct TicTacToeBigGameState : public GameState< TicTacToeBigGame >
 {
-    using Result = TicTacToeState::Result;
     using Cell = TicTacToeState::Cell;
     using BigBoard = std::vector< std::vector< TicTacToeState::Board > >;
-    using ResultBoard = std::vector< std::vector< Result > >;
 
     TicTacToeBigGameState( BigBoard&& board, bool my_turn, Cell&& last_move = {-1, -1} );
 
 private:
-    virtual std::unique_ptr< TicTacToeState > clone( ) const override;
-    virtual Result game_state( ) const override;
-    virtual Moves get_possible_moves( ) const override;
-    virtual void play_move( const Cell& cell ) override;
-
-private:
-    Cell get_board_coord( const Cell& cell ) const;
-    void append_board_moves( Moves& moves, size_t row, size_t col ) const;
-
-private:
-    BigBoard m_board;
-    ResultBoard m_results;
+    static TicTacToeBigGame::State make_state( const BigBoard& board,
+                                               bool my_turn,
+                                               const Cell& last_move );
 };
 
-}  // namespace mcts
\ No newline at end of file
+}  // namespace mcts
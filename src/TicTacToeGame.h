@@ -0,0 +1,169 @@
+#pragma once
+
+#include "BitBoard.h"
+#include "MctsState.h"
+#include "MoveList.h"
+#include "TicTacToePlayout.h"
+#include "Zobrist.h"
+
+#include <cstring>
+
+namespace mcts
+{
+// Classic 3x3 game for the Mcts< Game > template, a move is the cell index row * 3 + col
+struct TicTacToeGame
+{
+    using Mask = bitboard::Mask;
+
+    static constexpr int BOARD_SIZE = bitboard::SIZE;
+    static constexpr int MAX_MOVES = bitboard::CELLS;
+
+    using Moves = MoveList< MAX_MOVES >;
+
+    struct State
+    {
+        Mask mine;
+        Mask opponent;
+        bool my_turn;
+        // Zobrist hash of the marks and the side to move, updated on every move
+        Hash hash;
+        // Updated on every move from the lines through the played cell
+        MctsState::Result result;
+    };
+
+    static State
+    make_state( Mask mine, Mask opponent, bool my_turn )
+    {
+        return {mine, opponent, my_turn,
+                get_hash( mine, opponent, 0 ) ^ ( my_turn ? 0 : zobrist::side_key( ) ),
+                get_result( mine, opponent )};
+    }
+
+    // True when `state` holds a position of the game whose hash and result match its marks.
+    // Positions read from files are checked before they are searched, from their bytes since
+    // `my_turn` may be neither true nor false.
+    static bool
+    is_valid( const State& state )
+    {
+        return is_valid_turn( state.my_turn ) && is_valid_board( state.mine, state.opponent )
+               && state.hash == make_state( state.mine, state.opponent, state.my_turn ).hash
+               && state.result == get_result( state.mine, state.opponent );
+    }
+
+    static bool
+    is_valid_turn( const bool& my_turn )
+    {
+        unsigned char byte;
+        std::memcpy( &byte, &my_turn, sizeof( byte ) );
+        return byte <= 1;
+    }
+
+    // Marks only on the board and never two on one cell
+    static bool
+    is_valid_board( Mask mine, Mask opponent )
+    {
+        return ( ( mine | opponent ) & ~bitboard::FULL ) == 0 && ( mine & opponent ) == 0;
+    }
+
+    static MctsState::Result
+    get_result( const State& state )
+    {
+        return state.result;
+    }
+
+    // Scans all lines, positions that are played into are updated by get_result_after( )
+    static MctsState::Result
+    get_result( Mask mine, Mask opponent )
+    {
+        if ( bitboard::is_win( mine ) )
+        {
+            return MctsState::Result::e_Result_Hit;
+        }
+
+        if ( bitboard::is_win( opponent ) )
+        {
+            return MctsState::Result::e_Result_Miss;
+        }
+
+        return ( mine | opponent ) == bitboard::FULL ? MctsState::Result::e_Result_Draw
+                                                     : MctsState::Result::e_Result_NotFinished;
+    }
+
+    // Result once `cell` was marked for `my_turn`, the board was not finished before
+    static MctsState::Result
+    get_result_after( Mask mine, Mask opponent, int cell, bool my_turn )
+    {
+        if ( bitboard::is_win_through( my_turn ? mine : opponent, cell ) )
+        {
+            return my_turn ? MctsState::Result::e_Result_Hit : MctsState::Result::e_Result_Miss;
+        }
+
+        return ( mine | opponent ) == bitboard::FULL ? MctsState::Result::e_Result_Draw
+                                                     : MctsState::Result::e_Result_NotFinished;
+    }
+
+    static void
+    get_moves( const State& state, Moves& moves )
+    {
+        if ( state.result != MctsState::Result::e_Result_NotFinished )
+        {
+            return;
+        }
+
+        for ( Mask available = bitboard::FULL & ~( state.mine | state.opponent ); available;
+              available &= available - 1 )
+        {
+            moves.push_back( bitboard::lowest( available ) );
+        }
+    }
+
+    static void
+    play( State& state, Move move )
+    {
+        ( state.my_turn ? state.mine : state.opponent ) |= bitboard::cell_mask( move );
+        state.result = get_result_after( state.mine, state.opponent, move, state.my_turn );
+        state.hash ^= zobrist::cell_key( move, state.my_turn ) ^ zobrist::side_key( );
+        state.my_turn = !state.my_turn;
+    }
+
+    static MctsState::Result
+    simulate( const State& state, RandomEngine& random )
+    {
+        if ( state.result != MctsState::Result::e_Result_NotFinished )
+        {
+            return state.result;
+        }
+
+        return TicTacToePlayout( state.mine, state.opponent, state.my_turn ).run( random );
+    }
+
+    static bool
+    is_my_turn( const State& state )
+    {
+        return state.my_turn;
+    }
+
+    static Hash
+    get_hash( const State& state )
+    {
+        return state.hash;
+    }
+
+    // Hash of the marks of one board whose cells are numbered from `cell_offset`
+    static Hash
+    get_hash( Mask mine, Mask opponent, int cell_offset )
+    {
+        Hash hash = 0;
+        for ( ; mine; mine &= mine - 1 )
+        {
+            hash ^= zobrist::cell_key( cell_offset + bitboard::lowest( mine ), true );
+        }
+        for ( ; opponent; opponent &= opponent - 1 )
+        {
+            hash ^= zobrist::cell_key( cell_offset + bitboard::lowest( opponent ), false );
+        }
+        return hash;
+    }
+};
+
+}  // namespace mcts
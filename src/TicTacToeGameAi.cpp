@@ -1,12 +1,12 @@
 #include "TicTacToeGameAi.h"
-#include "MctsNode.h"
 
 #include <algorithm>
-#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
 
 namespace mcts
 {
-
 TicTacToeState::Board
 TicTacToeGameAI::create_small_board( const TicTacToeGameAI::AvailableCells& available )
 {
@@ -52,58 +52,214 @@ TicTacToeGameAI::create_big_board( const TicTacToeGameAI::AvailableCells& availa
     return big_board;
 }
 
-TicTacToeGameAI::TicTacToeGameAI( const AvailableCells& available, size_t iterations )
-    : m_iterations( iterations )
+TicTacToeGameAI::TicTacToeGameAI( const AvailableCells& available,
+                                  size_t iterations,
+                                  size_t threads,
+                                  uint64_t seed )
+    : TicTacToeGameAI( available, make_settings( iterations, threads, seed ) )
+{
+}
+
+TicTacToeGameAI::TicTacToeGameAI( const AvailableCells& available,
+                                  const SearchSettings& settings )
+    : m_settings( settings )
+    , m_search( create_search( available, settings ) )
+    , m_board_size( static_cast< int >( available.size( ) ) )
+    , m_my_move{-1, -1}
+    , m_stop_search( false )
+{
+    think( );
+}
+
+TicTacToeGameAI::~TicTacToeGameAI( )
+{
+    stop_pondering( );
+}
+
+void
+TicTacToeGameAI::opponent_move( const MovePosition& position )
+{
+    play_opponent_move( position );
+    think( );
+}
+
+void
+TicTacToeGameAI::opponent_move( const MovePosition& position, Clock::time_point deadline )
+{
+    play_opponent_move( position );
+    search( std::numeric_limits< size_t >::max( ), deadline );
+    m_statistics = m_search->get_statistics( );
+    play_best_move( );
+    start_pondering( );
+}
+
+MovePosition
+TicTacToeGameAI::get_my_move( ) const
+{
+    return m_my_move;
+}
+
+size_t
+TicTacToeGameAI::get_search_iterations( ) const
+{
+    return m_statistics.iterations;
+}
+
+const SearchStatistics&
+TicTacToeGameAI::get_search_statistics( ) const
+{
+    return m_statistics;
+}
+
+bool
+TicTacToeGameAI::save_snapshot( const std::string& path )
 {
-    std::unique_ptr< MctsState > state(
-        available.size( ) > 3 ? new TicTacToeBigGameState( create_big_board( available ), true )
-                              : new TicTacToeState( create_small_board( available ), true ) );
-    m_tree = std::make_shared< MctsNode >( std::move( state ) );
+    // Pondering resumes on the same trees afterwards
+    stop_pondering( );
+    auto const saved = m_search->save_snapshot( path );
+    start_pondering( );
+    return saved;
+}
+
+bool
+TicTacToeGameAI::load_snapshot( const std::string& path )
+{
+    stop_pondering( );
+    auto const loaded = m_search->load_snapshot( path );
+    start_pondering( );
+    return loaded;
+}
+
+void
+TicTacToeGameAI::play_opponent_move( const MovePosition& position )
+{
+    // Statistics gathered while pondering stay in the subtree of the opponent move
+    stop_pondering( );
 
-    // Play Move
-    // Save move position
-    int cnt = m_iterations;
-    while ( cnt-- > 0 )
+    if ( position.row < 0 || position.row >= m_board_size || position.col < 0
+         || position.col >= m_board_size || !m_search->is_legal( get_move( position ) ) )
     {
-        m_tree->choose_child( );
+        start_pondering( );
+        throw std::invalid_argument( "illegal opponent move" );
     }
-    m_current_node = m_tree->choose_child( );
+    m_search->play_move( get_move( position ) );
 }
 
 void
-TicTacToeGameAI::opponent_move( const MovePosition& position )
+TicTacToeGameAI::think( )
+{
+    if ( m_settings.time_budget > std::chrono::milliseconds::zero( ) )
+    {
+        search( std::numeric_limits< size_t >::max( ), Clock::now( ) + m_settings.time_budget );
+    }
+    else
+    {
+        search( m_settings.iterations, Clock::time_point::max( ) );
+    }
+    m_statistics = m_search->get_statistics( );
+    play_best_move( );
+    start_pondering( );
+}
+
+void
+TicTacToeGameAI::start_pondering( )
 {
-    auto current_node_strong_ref = m_current_node.lock( );
-    TicTacToeState::Cell const state_cell{position.row, position.col};
+    if ( !m_settings.ponder || m_search->is_finished( ) )
+    {
+        return;
+    }
+
+    // Pondering gets the budget of one move, so the trees do not grow without bound while the
+    // opponent thinks
+    if ( m_settings.time_budget > std::chrono::milliseconds::zero( ) )
+    {
+        auto const deadline = Clock::now( ) + m_settings.time_budget;
+        m_ponder_thread = std::thread(
+            [this, deadline]( ) { search( std::numeric_limits< size_t >::max( ), deadline ); } );
+    }
+    else
+    {
+        m_ponder_thread = std::thread(
+            [this]( ) { search( m_settings.iterations, Clock::time_point::max( ) ); } );
+    }
+}
 
-    // Ensure current node has children
-    current_node_strong_ref->choose_child( );
+void
+TicTacToeGameAI::stop_pondering( )
+{
+    if ( m_ponder_thread.joinable( ) )
+    {
+        m_stop_search.store( true, std::memory_order_relaxed );
+        m_ponder_thread.join( );
+        m_stop_search.store( false, std::memory_order_relaxed );
+    }
+}
 
-    // Get opponent child
-    auto opponent_child
-        = current_node_strong_ref->find_child( [&position]( const MctsState& state ) {
-              auto const& tic_tac_toe_state = dynamic_cast< TicTacToeState const& >( state );
-              auto const& last_move = tic_tac_toe_state.get_last_move( );
-              return last_move.row == position.row && last_move.col == position.col;
-          } );
+size_t
+TicTacToeGameAI::search( size_t iterations, Clock::time_point deadline )
+{
+    return m_search->search( iterations, deadline, m_stop_search );
+}
 
-    // Play Move
-    // Save move position
-    int cnt = m_iterations;
-    while ( cnt-- > 0 )
+void
+TicTacToeGameAI::play_best_move( )
+{
+    auto const best = m_search->get_best_move( );
+    if ( best < 0 )
     {
-        opponent_child->choose_child( );
+        if ( !m_search->is_finished( ) )
+        {
+            throw std::logic_error( "no move found in an unfinished game" );
+        }
+        // Game is finished, like a reply of the MatchServer
+        m_my_move = {-1, -1};
+        return;
     }
-    m_current_node = opponent_child->choose_child( );
+
+    m_my_move = get_move_position( best );
+    m_search->play_move( best );
 }
 
 MovePosition
-TicTacToeGameAI::get_my_move( ) const
+TicTacToeGameAI::get_move_position( Move move ) const
+{
+    return {move / m_board_size, move % m_board_size};
+}
+
+Move
+TicTacToeGameAI::get_move( const MovePosition& position ) const
 {
-    auto move_pos = dynamic_cast< TicTacToeState const& >( m_current_node.lock( )->get_state( ) )
-                        .get_last_move( );
+    return position.row * m_board_size + position.col;
+}
+
+std::unique_ptr< MctsSearch >
+TicTacToeGameAI::create_search( const AvailableCells& available, const SearchSettings& settings )
+{
+    if ( available.size( ) > SMALL_BOARD_SIZE )
+    {
+        auto const state
+            = TicTacToeBigGameState( create_big_board( available ), true ).get_state( );
+        if ( settings.tactical_playouts )
+        {
+            return std::unique_ptr< MctsSearch >(
+                new GameSearch< TacticalTicTacToeBigGame >( state, settings ) );
+        }
+        return std::unique_ptr< MctsSearch >(
+            new GameSearch< TicTacToeBigGame >( state, settings ) );
+    }
 
-    return {move_pos.row, move_pos.col};
+    return std::unique_ptr< MctsSearch >( new GameSearch< TicTacToeGame >(
+        TicTacToeState( create_small_board( available ), true ).get_state( ), settings ) );
+}
+
+SearchSettings
+TicTacToeGameAI::make_settings( size_t iterations, size_t threads, uint64_t seed )
+{
+    SearchSettings settings;
+    settings.iterations = iterations;
+    settings.threads = threads;
+    settings.seed = seed;
+    return settings;
 }
 
-}  // namespace mcts
\ No newline at end of file
+}  // namespace mcts
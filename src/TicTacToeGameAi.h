@@ -1,15 +1,18 @@
 #pragma once
 
+#include "MctsSearch.h"
 #include "TicTacToeBigGameState.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <thread>
 #include <vector>
 
 namespace mcts
 {
-struct MctsNode;
-using MctsNodePtr = std::shared_ptr< MctsNode >;
-
 struct MovePosition
 {
     int row;
@@ -22,13 +25,53 @@ struct TicTacToeGameAI
     static const size_t BIG_BOARD_SIZE = SMALL_BOARD_SIZE * SMALL_BOARD_SIZE;
 
     using AvailableCells = std::vector< std::vector< bool > >;
+    using Clock = std::chrono::steady_clock;
+
+    TicTacToeGameAI( const AvailableCells& available,
+                     size_t iterations = 0,
+                     size_t threads = 1,
+                     uint64_t seed = 0 );
+    TicTacToeGameAI( const AvailableCells& available, const SearchSettings& settings );
+    ~TicTacToeGameAI( );
 
-    TicTacToeGameAI( const AvailableCells& available, size_t iterations = 0 );
+    TicTacToeGameAI( const TicTacToeGameAI& ) = delete;
+    TicTacToeGameAI& operator=( const TicTacToeGameAI& ) = delete;
 
+    // Throws std::invalid_argument when `position` cannot be played, the game is unchanged then
     void opponent_move( const MovePosition& position );
+    // Searches the reply until `deadline` instead of the configured budget
+    void opponent_move( const MovePosition& position, Clock::time_point deadline );
+    // {-1, -1} when the game was finished before the AI could move
     MovePosition get_my_move( ) const;
+    // Iterations completed by all workers during the last search, one per selected leaf
+    size_t get_search_iterations( ) const;
+    // Statistics of the search for the last move, without pondering
+    const SearchStatistics& get_search_statistics( ) const;
+    // Saves the current position with all search trees, so a restarted or migrated game can
+    // resume searching where it stopped. False when the file cannot be written.
+    bool save_snapshot( const std::string& path );
+    // Continues the game of a snapshot of the same board size, the next opponent move is played
+    // on its position. The last move of the AI is not part of the snapshot. False when the file
+    // does not hold a snapshot of this game.
+    bool load_snapshot( const std::string& path );
+
+    // Search of the game with the board size of `available`, where the AI is to move
+    static std::unique_ptr< MctsSearch > create_search( const AvailableCells& available,
+                                                        const SearchSettings& settings );
 
 private:
+    void play_opponent_move( const MovePosition& position );
+    void think( );
+    void start_pondering( );
+    void stop_pondering( );
+    size_t search( size_t iterations, Clock::time_point deadline );
+    void play_best_move( );
+
+    MovePosition get_move_position( Move move ) const;
+    Move get_move( const MovePosition& position ) const;
+
+    static SearchSettings make_settings( size_t iterations, size_t threads, uint64_t seed );
+
     static TicTacToeState::Board
         create_small_board(const AvailableCells& available);
 
@@ -36,8 +79,13 @@ private:
         create_big_board(const AvailableCells& available);
 
 private:
-    const size_t m_iterations;
-    MctsNodePtr m_tree;
-    std::weak_ptr< MctsNode > m_current_node;
+    const SearchSettings m_settings;
+    // Compiled for the game of the board size
+    std::unique_ptr< MctsSearch > m_search;
+    const int m_board_size;
+    MovePosition m_my_move;
+    SearchStatistics m_statistics;
+    std::atomic< bool > m_stop_search;
+    std::thread m_ponder_thread;
 };
 }  // namespace mcts
@@ -0,0 +1,291 @@
+#include "TicTacToePlayout.h"
+
+namespace mcts
+{
+namespace
+{
+MctsState::Result
+get_winner_result( int player )
+{
+    return player == 0 ? MctsState::Result::e_Result_Hit : MctsState::Result::e_Result_Miss;
+}
+
+int
+fill_free_cells( std::array< int8_t, bitboard::CELLS >& free_cells, bitboard::Mask occupied )
+{
+    int free_count = 0;
+    for ( bitboard::Mask available = bitboard::FULL & ~occupied; available;
+          available &= available - 1 )
+    {
+        free_cells[ free_count++ ] = static_cast< int8_t >( bitboard::lowest( available ) );
+    }
+    return free_count;
+}
+
+// Cells that complete a line of the marks of every 9-bit mask, occupied or not
+std::array< bitboard::Mask, 1 << bitboard::CELLS >
+make_winning_cells( )
+{
+    std::array< bitboard::Mask, 1 << bitboard::CELLS > winning_cells;
+    for ( int marks = 0; marks <= bitboard::FULL; ++marks )
+    {
+        bitboard::Mask cells = 0;
+        for ( auto line : bitboard::LINES )
+        {
+            if ( bitboard::count( static_cast< bitboard::Mask >( marks & line ) ) == 2 )
+            {
+                cells |= line & ~marks;
+            }
+        }
+        winning_cells[ marks ] = cells;
+    }
+    return winning_cells;
+}
+
+const std::array< bitboard::Mask, 1 << bitboard::CELLS > WINNING_CELLS = make_winning_cells( );
+
+// Uniformly random cell of a non-empty mask
+int
+pick_cell( RandomEngine& random, bitboard::Mask cells )
+{
+    return bitboard::nth( cells,
+                          static_cast< int >( bounded( random, bitboard::count( cells ) ) ) );
+}
+
+}  // namespace
+
+TicTacToePlayout::TicTacToePlayout( Mask mine, Mask opponent, bool my_turn )
+    : m_marks{{mine, opponent}}
+    , m_free_count( fill_free_cells( m_free_cells, mine | opponent ) )
+    , m_player( my_turn ? 0 : 1 )
+{
+}
+
+MctsState::Result
+TicTacToePlayout::run( RandomEngine& random )
+{
+    while ( true )
+    {
+        auto const pick = static_cast< int >( bounded( random, m_free_count ) );
+        auto const cell = m_free_cells[ pick ];
+        m_free_cells[ pick ] = m_free_cells[ --m_free_count ];
+
+        auto& marks = m_marks[ m_player ];
+        marks |= bitboard::cell_mask( cell );
+        if ( bitboard::is_win_through( marks, cell ) )
+        {
+            return get_winner_result( m_player );
+        }
+
+        if ( m_free_count == 0 )
+        {
+            return MctsState::Result::e_Result_Draw;
+        }
+
+        m_player ^= 1;
+    }
+}
+
+TicTacToeBigGamePlayout::TicTacToeBigGamePlayout( const Boards& mine,
+                                                  const Boards& opponent,
+                                                  Mask won_mine,
+                                                  Mask won_opponent,
+                                                  Mask drawn,
+                                                  int target_board,
+                                                  bool my_turn )
+    : m_marks{{mine, opponent}}
+    , m_won{{won_mine, won_opponent}}
+    , m_open( bitboard::FULL & ~( won_mine | won_opponent | drawn ) )
+    , m_target_board( target_board )
+    , m_player( my_turn ? 0 : 1 )
+{
+    for ( int board = 0; board < bitboard::CELLS; ++board )
+    {
+        m_free_count[ board ] = static_cast< int8_t >(
+            fill_free_cells( m_free_cells[ board ], mine[ board ] | opponent[ board ] ) );
+    }
+}
+
+MctsState::Result
+TicTacToeBigGamePlayout::run( RandomEngine& random )
+{
+    MctsState::Result result;
+    while ( true )
+    {
+        int pick = 0;
+        auto const board = choose_board( random, pick );
+
+        auto& free_cells = m_free_cells[ board ];
+        auto const cell = free_cells[ pick ];
+        free_cells[ pick ] = free_cells[ m_free_count[ board ] - 1 ];
+        if ( play_cell( board, cell, result ) )
+        {
+            return result;
+        }
+    }
+}
+
+MctsState::Result
+TicTacToeBigGamePlayout::run_tactical( RandomEngine& random )
+{
+    MctsState::Result result;
+    while ( true )
+    {
+        int board = 0;
+        auto const cell = choose_tactical_cell( random, board );
+        if ( play_cell( board, cell, result ) )
+        {
+            return result;
+        }
+    }
+}
+
+int
+TicTacToeBigGamePlayout::choose_board( RandomEngine& random, int& pick ) const
+{
+    if ( m_target_board >= 0 && ( m_open & bitboard::cell_mask( m_target_board ) ) )
+    {
+        pick = static_cast< int >( bounded( random, m_free_count[ m_target_board ] ) );
+        return m_target_board;
+    }
+
+    // Any free cell of any open board
+    int total = 0;
+    for ( Mask boards = m_open; boards; boards &= boards - 1 )
+    {
+        total += m_free_count[ bitboard::lowest( boards ) ];
+    }
+
+    auto n = static_cast< int >( bounded( random, total ) );
+    for ( Mask boards = m_open;; boards &= boards - 1 )
+    {
+        auto const board = bitboard::lowest( boards );
+        if ( n < m_free_count[ board ] )
+        {
+            pick = n;
+            return board;
+        }
+        n -= m_free_count[ board ];
+    }
+}
+
+int
+TicTacToeBigGamePlayout::choose_tactical_cell( RandomEngine& random, int& board ) const
+{
+    auto const opponent = m_player ^ 1;
+    auto const forced
+        = m_target_board >= 0 && ( m_open & bitboard::cell_mask( m_target_board ) );
+    auto const targets = forced ? bitboard::cell_mask( m_target_board ) : m_open;
+
+    // Boards whose win completes a line of the meta board win the game
+    auto const winning_boards = WINNING_CELLS[ m_won[ m_player ] ];
+    int win_board = -1;
+    Mask wins = 0;
+    for ( Mask boards = targets; boards; boards &= boards - 1 )
+    {
+        auto const candidate = bitboard::lowest( boards );
+        auto const candidate_wins
+            = WINNING_CELLS[ m_marks[ m_player ][ candidate ] ] & get_free_cells( candidate );
+        if ( !candidate_wins )
+        {
+            continue;
+        }
+
+        auto const wins_game = ( winning_boards & bitboard::cell_mask( candidate ) ) != 0;
+        if ( win_board < 0 || wins_game )
+        {
+            win_board = candidate;
+            wins = candidate_wins;
+        }
+        if ( wins_game )
+        {
+            break;
+        }
+    }
+    if ( win_board >= 0 )
+    {
+        board = win_board;
+        return pick_cell( random, wins );
+    }
+
+    // The cell also selects the board of the opponent, open boards keep it confined
+    if ( forced )
+    {
+        board = m_target_board;
+        auto const free = get_free_cells( board );
+        auto const blocks = WINNING_CELLS[ m_marks[ opponent ][ board ] ] & free;
+        auto const confined = free & m_open;
+        return pick_cell( random, blocks ? blocks : confined ? confined : free );
+    }
+
+    // Any board may be chosen, confining cells are picked uniformly over all open boards
+    int total = 0;
+    for ( Mask boards = targets; boards; boards &= boards - 1 )
+    {
+        total += bitboard::count( get_free_cells( bitboard::lowest( boards ) ) & m_open );
+    }
+
+    auto const confined = total > 0 ? m_open : bitboard::FULL;
+    if ( total == 0 )
+    {
+        for ( Mask boards = targets; boards; boards &= boards - 1 )
+        {
+            total += bitboard::count( get_free_cells( bitboard::lowest( boards ) ) );
+        }
+    }
+
+    auto n = static_cast< int >( bounded( random, total ) );
+    for ( Mask boards = targets;; boards &= boards - 1 )
+    {
+        board = bitboard::lowest( boards );
+        auto const cells = get_free_cells( board ) & confined;
+        auto const count = bitboard::count( cells );
+        if ( n < count )
+        {
+            return bitboard::nth( cells, n );
+        }
+        n -= count;
+    }
+}
+
+TicTacToeBigGamePlayout::Mask
+TicTacToeBigGamePlayout::get_free_cells( int board ) const
+{
+    return bitboard::FULL & ~( m_marks[ 0 ][ board ] | m_marks[ 1 ][ board ] );
+}
+
+bool
+TicTacToeBigGamePlayout::play_cell( int board, int cell, MctsState::Result& result )
+{
+    auto const board_mask = bitboard::cell_mask( board );
+    --m_free_count[ board ];
+
+    auto& marks = m_marks[ m_player ][ board ];
+    marks |= bitboard::cell_mask( cell );
+    if ( bitboard::is_win_through( marks, cell ) )
+    {
+        m_won[ m_player ] |= board_mask;
+        m_open &= ~board_mask;
+        if ( bitboard::is_win_through( m_won[ m_player ], board ) )
+        {
+            result = get_winner_result( m_player );
+            return true;
+        }
+    }
+    else if ( m_free_count[ board ] == 0 )
+    {
+        m_open &= ~board_mask;
+    }
+
+    if ( !m_open )
+    {
+        result = MctsState::Result::e_Result_Draw;
+        return true;
+    }
+
+    m_target_board = cell;
+    m_player ^= 1;
+    return false;
+}
+
+}  // namespace mcts
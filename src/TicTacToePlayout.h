@@ -0,0 +1,69 @@
+#pragma once
+
+#include "BitBoard.h"
+#include "MctsState.h"
+
+#include <array>
+
+namespace mcts
+{
+// Random playouts run on these fixed-size scratch states, which are meant to live on the stack.
+// Free cells are kept in a list with swap-remove, and after every move only the lines through
+// the played cell are checked. The start position must not be finished.
+struct TicTacToePlayout
+{
+    using Mask = bitboard::Mask;
+
+    TicTacToePlayout( Mask mine, Mask opponent, bool my_turn );
+
+    MctsState::Result run( RandomEngine& random );
+
+private:
+    // Index 0 is my side, index 1 the opponent
+    std::array< Mask, 2 > m_marks;
+    std::array< int8_t, bitboard::CELLS > m_free_cells;
+    int m_free_count;
+    int m_player;
+};
+
+struct TicTacToeBigGamePlayout
+{
+    using Mask = bitboard::Mask;
+    using Boards = std::array< Mask, bitboard::CELLS >;
+
+    // `target_board` is the board the next move has to be played on, -1 for any open board
+    TicTacToeBigGamePlayout( const Boards& mine,
+                             const Boards& opponent,
+                             Mask won_mine,
+                             Mask won_opponent,
+                             Mask drawn,
+                             int target_board,
+                             bool my_turn );
+
+    // Uniformly random moves
+    MctsState::Result run( RandomEngine& random );
+    // Takes a move that wins a small board, preferring one that wins the game, then blocks a
+    // board win of the opponent on the target board and otherwise avoids sending the opponent
+    // to a finished board, where it could choose any board. Ties are broken at random.
+    MctsState::Result run_tactical( RandomEngine& random );
+
+private:
+    int choose_board( RandomEngine& random, int& pick ) const;
+    // Cell of `board` chosen by the tactical policy
+    int choose_tactical_cell( RandomEngine& random, int& board ) const;
+    Mask get_free_cells( int board ) const;
+    // Marks `cell` of `board` for the side to move, true once this finishes the game
+    bool play_cell( int board, int cell, MctsState::Result& result );
+
+private:
+    std::array< Boards, 2 > m_marks;
+    std::array< Mask, 2 > m_won;
+    Mask m_open;
+    // Only kept up to date by run( )
+    std::array< std::array< int8_t, bitboard::CELLS >, bitboard::CELLS > m_free_cells;
+    std::array< int8_t, bitboard::CELLS > m_free_count;
+    int m_target_board;
+    int m_player;
+};
+
+}  // namespace mcts
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "MctsState.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace mcts
+{
+// Fixed-size table from position hash to the node of that position. Every bucket holds two
+// entries; when both are taken a new node replaces the less visited one. The table is not
+// thread safe.
+template < typename Node >
+struct TranspositionTable
+{
+    // The size is rounded down to a power of two, a size below two disables the table
+    explicit TranspositionTable( size_t size );
+
+    bool is_enabled( ) const;
+    Node* find( Hash hash ) const;
+    void insert( Hash hash, Node* node );
+    void clear( );
+    // Bytes of the entries, reserved once when the table is created
+    size_t get_memory_usage( ) const;
+
+private:
+    struct Entry
+    {
+        Hash hash;
+        Node* node;
+    };
+
+    static size_t round_down_to_power_of_two( size_t size );
+    size_t get_bucket( Hash hash ) const;
+
+private:
+    std::vector< Entry > m_entries;
+};
+
+template < typename Node >
+TranspositionTable< Node >::TranspositionTable( size_t size )
+    : m_entries( size < 2 ? 0 : round_down_to_power_of_two( size ), Entry{0, nullptr} )
+{
+}
+
+template < typename Node >
+bool
+TranspositionTable< Node >::is_enabled( ) const
+{
+    return !m_entries.empty( );
+}
+
+template < typename Node >
+Node*
+TranspositionTable< Node >::find( Hash hash ) const
+{
+    auto const bucket = get_bucket( hash );
+    for ( size_t i = bucket; i < bucket + 2; ++i )
+    {
+        if ( m_entries[ i ].node && m_entries[ i ].hash == hash )
+        {
+            return m_entries[ i ].node;
+        }
+    }
+    return nullptr;
+}
+
+template < typename Node >
+void
+TranspositionTable< Node >::insert( Hash hash, Node* node )
+{
+    auto const bucket = get_bucket( hash );
+    auto& first = m_entries[ bucket ];
+    auto& second = m_entries[ bucket + 1 ];
+
+    Entry* replaced = nullptr;
+    if ( !first.node || first.hash == hash )
+    {
+        replaced = &first;
+    }
+    else if ( !second.node || second.hash == hash )
+    {
+        replaced = &second;
+    }
+    else
+    {
+        replaced = first.node->get_total_trials( ) <= second.node->get_total_trials( ) ? &first
+                                                                                       : &second;
+    }
+
+    *replaced = Entry{hash, node};
+}
+
+template < typename Node >
+void
+TranspositionTable< Node >::clear( )
+{
+    std::fill( m_entries.begin( ), m_entries.end( ), Entry{0, nullptr} );
+}
+
+template < typename Node >
+size_t
+TranspositionTable< Node >::get_memory_usage( ) const
+{
+    return m_entries.capacity( ) * sizeof( Entry );
+}
+
+template < typename Node >
+size_t
+TranspositionTable< Node >::round_down_to_power_of_two( size_t size )
+{
+    size_t result = 1;
+    while ( result <= size / 2 )
+    {
+        result *= 2;
+    }
+    return result;
+}
+
+template < typename Node >
+size_t
+TranspositionTable< Node >::get_bucket( Hash hash ) const
+{
+    return static_cast< size_t >( hash ) & ( m_entries.size( ) - 2 );
+}
+
+}  // namespace mcts
@@ -0,0 +1,248 @@
+#include "TreeSnapshot.h"
+
+#include "MctsNode.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+namespace mcts
+{
+namespace
+{
+const char MAGIC[ 8 ] = {'M', 'C', 'T', 'S', 'T', 'R', 'E', 'E'};
+const char PADDING[ 8 ] = {};
+
+}  // namespace
+
+bool
+TreeSnapshot::open( const std::string& path, int board_size, size_t state_size )
+{
+    m_trees.clear( );
+    if ( !m_file.open( path ) )
+    {
+        return false;
+    }
+
+    auto const data = static_cast< const char* >( m_file.data( ) );
+    auto const size = m_file.size( );
+    Header header;
+    if ( size < sizeof( header ) )
+    {
+        m_file.close( );
+        return false;
+    }
+
+    std::memcpy( &header, data, sizeof( header ) );
+    if ( std::memcmp( header.magic, MAGIC, sizeof( MAGIC ) ) != 0 || header.version != VERSION
+         || header.board_size != static_cast< uint32_t >( board_size )
+         || header.state_size != state_size || header.tree_count == 0 )
+    {
+        m_file.close( );
+        return false;
+    }
+
+    // Every count is checked against the bytes left before it is used
+    size_t offset = sizeof( header );
+    for ( uint32_t i = 0; i < header.tree_count; ++i )
+    {
+        TreeHeader tree_header;
+        if ( size - offset < sizeof( tree_header ) )
+        {
+            break;
+        }
+        std::memcpy( &tree_header, data + offset, sizeof( tree_header ) );
+        offset += sizeof( tree_header );
+
+        auto const padded_size = get_padded_size( state_size );
+        if ( size - offset < padded_size
+             || ( size - offset - padded_size ) / sizeof( Node ) < tree_header.node_count )
+        {
+            break;
+        }
+
+        TreeView tree;
+        tree.state = data + offset;
+        offset += padded_size;
+        tree.nodes = reinterpret_cast< const Node* >( data + offset );
+        tree.node_count = static_cast< size_t >( tree_header.node_count );
+        offset += tree.node_count * sizeof( Node );
+        if ( ( size - offset ) / sizeof( Edge ) < tree_header.edge_count )
+        {
+            break;
+        }
+
+        tree.edges = reinterpret_cast< const Edge* >( data + offset );
+        tree.edge_count = static_cast< size_t >( tree_header.edge_count );
+        offset += tree.edge_count * sizeof( Edge );
+        if ( !is_consistent( tree, board_size ) )
+        {
+            break;
+        }
+        m_trees.push_back( tree );
+    }
+
+    if ( m_trees.size( ) != header.tree_count )
+    {
+        m_trees.clear( );
+        m_file.close( );
+        return false;
+    }
+    return true;
+}
+
+bool
+TreeSnapshot::is_open( ) const
+{
+    return !m_trees.empty( );
+}
+
+size_t
+TreeSnapshot::get_tree_count( ) const
+{
+    return m_trees.size( );
+}
+
+const TreeSnapshot::TreeView&
+TreeSnapshot::get_tree( size_t index ) const
+{
+    return m_trees[ index ];
+}
+
+bool
+TreeSnapshot::write( const std::string& path, int board_size, const std::vector< Tree >& trees )
+{
+    static_assert( sizeof( Header ) % alignof( TreeHeader ) == 0
+                       && sizeof( TreeHeader ) % alignof( Node ) == 0
+                       && sizeof( Node ) % alignof( Edge ) == 0
+                       && alignof( Node ) <= sizeof( PADDING ),
+                   "trees follow the header aligned" );
+
+    if ( trees.empty( ) )
+    {
+        return false;
+    }
+
+    Header header;
+    std::memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+    header.version = VERSION;
+    header.board_size = static_cast< uint32_t >( board_size );
+    header.state_size = static_cast< uint32_t >( trees.front( ).state.size( ) );
+    header.tree_count = static_cast< uint32_t >( trees.size( ) );
+
+    std::ofstream file( path, std::ios::binary | std::ios::trunc );
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+    for ( auto const& tree : trees )
+    {
+        TreeHeader const tree_header{tree.nodes.size( ), tree.edges.size( )};
+        file.write( reinterpret_cast< const char* >( &tree_header ), sizeof( tree_header ) );
+        file.write( tree.state.data( ), static_cast< std::streamsize >( tree.state.size( ) ) );
+        file.write( PADDING, static_cast< std::streamsize >( get_padded_size( tree.state.size( ) )
+                                                             - tree.state.size( ) ) );
+        file.write( reinterpret_cast< const char* >( tree.nodes.data( ) ),
+                    static_cast< std::streamsize >( tree.nodes.size( ) * sizeof( Node ) ) );
+        file.write( reinterpret_cast< const char* >( tree.edges.data( ) ),
+                    static_cast< std::streamsize >( tree.edges.size( ) * sizeof( Edge ) ) );
+    }
+    return static_cast< bool >( file );
+}
+
+size_t
+TreeSnapshot::get_padded_size( size_t state_size )
+{
+    return ( state_size + sizeof( PADDING ) - 1 ) / sizeof( PADDING ) * sizeof( PADDING );
+}
+
+// Edges must be split exactly among the expanded nodes, hold moves on the board and only refer
+// to nodes of the tree without forming a cycle
+bool
+TreeSnapshot::is_consistent( const TreeView& tree, int board_size )
+{
+    if ( tree.node_count == 0 )
+    {
+        return false;
+    }
+
+    size_t edges = 0;
+    for ( size_t i = 0; i < tree.node_count; ++i )
+    {
+        auto const children = tree.nodes[ i ].children_count;
+        if ( children < -1 || tree.nodes[ i ].explored_count < 0
+             || tree.nodes[ i ].explored_count > std::max( children, 0 )
+             || tree.nodes[ i ].proof < static_cast< int32_t >( Proof::e_Proof_None )
+             || tree.nodes[ i ].proof > static_cast< int32_t >( Proof::e_Proof_Draw ) )
+        {
+            return false;
+        }
+        edges += static_cast< size_t >( std::max( children, 0 ) );
+    }
+    if ( edges != tree.edge_count )
+    {
+        return false;
+    }
+
+    for ( size_t i = 0; i < tree.edge_count; ++i )
+    {
+        auto const& edge = tree.edges[ i ];
+        if ( edge.move < 0 || edge.move >= board_size * board_size || edge.node < -1
+             || edge.node >= static_cast< int64_t >( tree.node_count ) )
+        {
+            return false;
+        }
+    }
+    return is_acyclic( tree );
+}
+
+// Depth first from the root, a cycle leads back to a node whose children are still walked.
+// Selection would follow it forever.
+bool
+TreeSnapshot::is_acyclic( const TreeView& tree )
+{
+    std::vector< size_t > first_edges( tree.node_count + 1, 0 );
+    for ( size_t i = 0; i < tree.node_count; ++i )
+    {
+        auto const children = std::max( tree.nodes[ i ].children_count, 0 );
+        first_edges[ i + 1 ] = first_edges[ i ] + static_cast< size_t >( children );
+    }
+
+    enum class Visit : uint8_t
+    {
+        e_Visit_New,
+        e_Visit_Open,
+        e_Visit_Done,
+    };
+    std::vector< Visit > visits( tree.node_count, Visit::e_Visit_New );
+    // Node and its next edge
+    std::vector< std::pair< size_t, size_t > > path{{0, first_edges[ 0 ]}};
+    visits[ 0 ] = Visit::e_Visit_Open;
+    while ( !path.empty( ) )
+    {
+        auto& top = path.back( );
+        if ( top.second == first_edges[ top.first + 1 ] )
+        {
+            visits[ top.first ] = Visit::e_Visit_Done;
+            path.pop_back( );
+            continue;
+        }
+
+        auto const child = tree.edges[ top.second++ ].node;
+        if ( child < 0 )
+        {
+            continue;
+        }
+        auto const index = static_cast< size_t >( child );
+        if ( visits[ index ] == Visit::e_Visit_Open )
+        {
+            return false;
+        }
+        if ( visits[ index ] == Visit::e_Visit_New )
+        {
+            visits[ index ] = Visit::e_Visit_Open;
+            path.emplace_back( index, first_edges[ index ] );
+        }
+    }
+    return true;
+}
+
+}  // namespace mcts
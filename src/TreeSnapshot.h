@@ -0,0 +1,96 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "MctsState.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mcts
+{
+// Search trees of one game saved for a warm restart. Every tree is stored as the position of its
+// root, its nodes in preorder and the edges of all nodes in the same order. Children are referred
+// to by their preorder index, so a tree is restored in one pass without following pointers, and a
+// node reached through several parents is stored once. The file is in the byte order of the
+// machine that wrote it and is mapped into memory like an opening book.
+struct TreeSnapshot
+{
+    struct Node
+    {
+        // Position of the node, for the transposition table
+        Hash hash;
+        int32_t total_trials;
+        // -1 for a node that was not expanded
+        int32_t children_count;
+        int32_t explored_count;
+        // Proof of the node
+        int32_t proof;
+    };
+
+    struct Edge
+    {
+        int32_t move;
+        int32_t hits;
+        int32_t trials;
+        // Preorder index of the child, -1 when it was not visited
+        int32_t node;
+    };
+
+    // Tree to be written, the root is the first node
+    struct Tree
+    {
+        // Bytes of the root position
+        std::vector< char > state;
+        std::vector< Node > nodes;
+        std::vector< Edge > edges;
+    };
+
+    // Tree of an open snapshot, pointing into the file
+    struct TreeView
+    {
+        const void* state;
+        const Node* nodes;
+        size_t node_count;
+        const Edge* edges;
+        size_t edge_count;
+    };
+
+    // False when the file cannot be read, was written for another board size or position layout,
+    // or its trees are inconsistent. The positions of the roots are checked by the game.
+    bool open( const std::string& path, int board_size, size_t state_size );
+    bool is_open( ) const;
+    size_t get_tree_count( ) const;
+    const TreeView& get_tree( size_t index ) const;
+
+    static bool write( const std::string& path, int board_size, const std::vector< Tree >& trees );
+
+private:
+    struct Header
+    {
+        char magic[ 8 ];
+        uint32_t version;
+        uint32_t board_size;
+        uint32_t state_size;
+        uint32_t tree_count;
+    };
+
+    struct TreeHeader
+    {
+        uint64_t node_count;
+        uint64_t edge_count;
+    };
+
+    static const uint32_t VERSION = 3;
+
+    // Bytes of a position, padded so the nodes that follow are aligned
+    static size_t get_padded_size( size_t state_size );
+    static bool is_consistent( const TreeView& tree, int board_size );
+    static bool is_acyclic( const TreeView& tree );
+
+private:
+    MappedFile m_file;
+    std::vector< TreeView > m_trees;
+};
+
+}  // namespace mcts
@@ -0,0 +1,140 @@
+#include "UcbSelection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define MCTS_UCB_AVX2
+#include <immintrin.h>
+#endif
+
+namespace mcts
+{
+namespace
+{
+float
+ucb1( int hits, int trials, float log_parent_trials, float exploration )
+{
+    auto const n = static_cast< float >( std::max( trials, 1 ) );
+    return 0.5f * hits / n + exploration * std::sqrt( log_parent_trials / n );
+}
+
+int
+select_ucb1_scalar( const int* hits,
+                    const int* trials,
+                    const int* skipped,
+                    int begin,
+                    int count,
+                    float log_parent_trials,
+                    float exploration,
+                    float& best_value )
+{
+    int best_index = -1;
+    for ( int i = begin; i < count; ++i )
+    {
+        if ( skipped[ i ] )
+        {
+            continue;
+        }
+
+        auto const value = ucb1( hits[ i ], trials[ i ], log_parent_trials, exploration );
+        if ( value > best_value )
+        {
+            best_value = value;
+            best_index = i;
+        }
+    }
+    return best_index;
+}
+
+#ifdef MCTS_UCB_AVX2
+__attribute__( ( target( "avx2" ) ) ) int
+select_ucb1_avx2( const int* hits,
+                  const int* trials,
+                  const int* skipped,
+                  int count,
+                  float log_parent_trials,
+                  float exploration )
+{
+    auto const lanes = 8;
+    auto const log_n = _mm256_set1_ps( log_parent_trials );
+    auto const c = _mm256_set1_ps( exploration );
+    auto const half = _mm256_set1_ps( 0.5f );
+    auto const zero = _mm256_setzero_si256( );
+    auto const one = _mm256_set1_epi32( 1 );
+    auto const step = _mm256_set1_epi32( lanes );
+
+    auto best = _mm256_set1_ps( std::numeric_limits< float >::lowest( ) );
+    auto best_indices = _mm256_set1_epi32( -1 );
+    auto indices = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+
+    int i = 0;
+    for ( ; i + lanes <= count; i += lanes )
+    {
+        auto const w = _mm256_mul_ps(
+            half, _mm256_cvtepi32_ps(
+                      _mm256_loadu_si256( reinterpret_cast< const __m256i* >( hits + i ) ) ) );
+        auto const n = _mm256_cvtepi32_ps( _mm256_max_epi32(
+            _mm256_loadu_si256( reinterpret_cast< const __m256i* >( trials + i ) ), one ) );
+        auto const value
+            = _mm256_add_ps( _mm256_div_ps( w, n ),
+                             _mm256_mul_ps( c, _mm256_sqrt_ps( _mm256_div_ps( log_n, n ) ) ) );
+
+        // Skipped lanes never compare greater
+        auto const open = _mm256_cmpeq_epi32(
+            _mm256_loadu_si256( reinterpret_cast< const __m256i* >( skipped + i ) ), zero );
+        auto const greater = _mm256_and_ps( _mm256_cmp_ps( value, best, _CMP_GT_OQ ),
+                                            _mm256_castsi256_ps( open ) );
+        best = _mm256_blendv_ps( best, value, greater );
+        best_indices
+            = _mm256_blendv_epi8( best_indices, indices, _mm256_castps_si256( greater ) );
+        indices = _mm256_add_epi32( indices, step );
+    }
+
+    alignas( 32 ) float values[ lanes ];
+    alignas( 32 ) int value_indices[ lanes ];
+    _mm256_store_ps( values, best );
+    _mm256_store_si256( reinterpret_cast< __m256i* >( value_indices ), best_indices );
+
+    auto best_value = std::numeric_limits< float >::lowest( );
+    int best_index = -1;
+    for ( int lane = 0; lane < lanes; ++lane )
+    {
+        if ( value_indices[ lane ] >= 0 && values[ lane ] > best_value )
+        {
+            best_value = values[ lane ];
+            best_index = value_indices[ lane ];
+        }
+    }
+
+    auto const tail_index = select_ucb1_scalar( hits, trials, skipped, i, count,
+                                                log_parent_trials, exploration, best_value );
+    return tail_index >= 0 ? tail_index : best_index;
+}
+#endif
+
+}  // namespace
+
+int
+select_ucb1( const int* hits,
+             const int* trials,
+             const int* skipped,
+             int count,
+             float log_parent_trials,
+             float exploration )
+{
+#ifdef MCTS_UCB_AVX2
+    static const bool has_avx2 = __builtin_cpu_supports( "avx2" );
+    if ( has_avx2 )
+    {
+        return select_ucb1_avx2( hits, trials, skipped, count, log_parent_trials, exploration );
+    }
+#endif
+
+    auto best_value = std::numeric_limits< float >::lowest( );
+    return select_ucb1_scalar( hits, trials, skipped, 0, count, log_parent_trials, exploration,
+                               best_value );
+}
+
+}  // namespace mcts
@@ -0,0 +1,21 @@
+#pragma once
+
+namespace mcts
+{
+// Exploration constant of UCB1, sqrt( 2 )
+const float UCB1_EXPLORATION = 1.41421356f;
+
+// Index of the child with the highest UCB1 value
+//     hits / ( 2 * trials ) + exploration * sqrt( log_parent_trials / trials )
+// `hits`, `trials` and `skipped` hold one value per child. Hits count two per win and one per
+// draw, children without trials count as one trial. Children with a nonzero `skipped` value are
+// never selected, -1 is returned when all children are skipped. Uses AVX2 when the processor
+// supports it.
+int select_ucb1( const int* hits,
+                 const int* trials,
+                 const int* skipped,
+                 int count,
+                 float log_parent_trials,
+                 float exploration );
+
+}  // namespace mcts
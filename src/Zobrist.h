@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "Random.h"
+
+namespace mcts
+{
+// Random keys for incremental position hashing, identical on every run
+namespace zobrist
+{
+const int CELLS = 81;
+const int PLAYERS = 2;
+const int TARGETS = 10;
+
+inline uint64_t
+key( int index )
+{
+    static const std::array< uint64_t, CELLS * PLAYERS + 1 + TARGETS > keys = []( ) {
+        std::array< uint64_t, CELLS * PLAYERS + 1 + TARGETS > result;
+        uint64_t seed = 0x9e3779b97f4a7c15ull;
+        for ( auto& value : result )
+        {
+            value = splitmix64( seed );
+        }
+        return result;
+    }( );
+    return keys[ index ];
+}
+
+inline uint64_t
+cell_key( int cell, bool mine )
+{
+    return key( cell * PLAYERS + ( mine ? 0 : 1 ) );
+}
+
+inline uint64_t
+side_key( )
+{
+    return key( CELLS * PLAYERS );
+}
+
+// Board the next move is forced to, -1 when any board may be chosen
+inline uint64_t
+target_key( int board )
+{
+    return key( CELLS * PLAYERS + 1 + ( board < 0 ? TARGETS - 1 : board ) );
+}
+
+}  // namespace zobrist
+}  // namespace mcts
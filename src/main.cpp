@@ -1,15 +1,10 @@
 #include "TicTacToeGameAi.h"
 
+#include <algorithm>
 #include <ctime>
 #include <iostream>
-
-namespace
-{
-const bool srand_init = []( ) {
-    srand( static_cast< unsigned int >( time( NULL ) ) );
-    return true;
-}( );
-}
+#include <stdexcept>
+#include <thread>
 
 using Brd = std::vector< std::vector< char > >;
 
@@ -42,8 +37,9 @@ print_board( const Brd& brd )
     }
 }
 
+// An opening book written by build_opening_book may be given as the only argument
 int
-main( )
+main( int argc, char** argv )
 {
     auto const board_size = BIG_BOARD_SIZE;
 
@@ -52,18 +48,51 @@ main( )
     std::vector< std::vector< bool > > available( board_size,
                                                   std::vector< bool >( board_size, true ) );
 
-    auto game = std::make_shared< mcts::TicTacToeGameAI >( available, 100 );
+    mcts::SearchSettings settings;
+    settings.iterations = 100;
+    settings.threads = std::max( std::thread::hardware_concurrency( ), 1u );
+    settings.seed = static_cast< uint64_t >( time( NULL ) );
+    if ( argc > 1 )
+    {
+        auto book = std::make_shared< mcts::OpeningBook >( );
+        if ( book->open( argv[ 1 ], static_cast< int >( board_size ) ) )
+        {
+            settings.opening_book = std::move( book );
+        }
+        else
+        {
+            std::cerr << "cannot open opening book " << argv[ 1 ] << std::endl;
+        }
+    }
+
+    auto game = std::make_shared< mcts::TicTacToeGameAI >( available, settings );
 
     bool cont = true;
     while ( cont )
     {
         auto ai_move = game->get_my_move( );
+        if ( ai_move.row < 0 )
+        {
+            print_board( visualization );
+            break;
+        }
         visualization[ ai_move.row ][ ai_move.col ] = 'X';
         print_board( visualization );
 
         mcts::MovePosition pos;
-        std::cin >> pos.row >> pos.col;
+        if ( !( std::cin >> pos.row >> pos.col ) )
+        {
+            break;
+        }
+        try
+        {
+            game->opponent_move( pos );
+        }
+        catch ( const std::invalid_argument& error )
+        {
+            std::cerr << error.what( ) << std::endl;
+            continue;
+        }
         visualization[ pos.row ][ pos.col ] = '0';
-        game->opponent_move( pos );
     }
 }